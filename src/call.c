@@ -33,15 +33,45 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <generic_types.h>
 #include <object.h>
 #include <call.h>
 #include <httperf.h>
 
+/* Requests larger than this are sent straight from the iov[].  */
+#define MAX_TEMPLATE_LEN	16384
+/* Number of slots in the (direct-mapped) template cache: */
+#define TEMPLATE_CACHE_SIZE	1024
+
 static u_long next_id = 0;
 
+/* The cache is keyed by where the pieces of a request are stored and
+   how long they are, which is cheap to compute, and a template is
+   reused for a request made from the very same buffers.  Only buffers
+   marked with call_set_reused() have their contents checked as well.
+   A request is serialized only the second time its key comes up; until
+   then (and for keys whose contents keep changing) it is sent from the
+   iov[] instead.  */
+static struct Tmpl_Slot
+  {
+    Req_Template *tmpl;		/* cached template (or 0) */
+    u_int seen_key;		/* key last seen without a template */
+    u_int volatile_key;		/* key whose contents changed */
+  }
+tmpl_cache[TEMPLATE_CACHE_SIZE];
+
+const char *const call_method_name[HM_OTHER] =
+  {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "TRACE", "CONNECT",
+    "PATCH", "PROPFIND", "REPORT"
+  };
+
 void
 call_init (Call *c)
 {
@@ -56,11 +86,141 @@ call_init (Call *c)
   c->req.iov[IE_NEWLINE1].iov_len = 2;
   c->req.iov[IE_NEWLINE2].iov_base = (caddr_t) "\r\n";
   c->req.iov[IE_NEWLINE2].iov_len = 2;
+  c->req.content_fd = -1;
+}
+
+static void
+tmpl_dec_ref (Req_Template *t)
+{
+  if (--t->ref_count == 0)
+    free (t);
 }
 
 void
 call_deinit (Call *call)
 {
+  if (call->req.tmpl)
+    tmpl_dec_ref (call->req.tmpl);
+}
+
+/* Return non-zero if template T was made from the buffers of the
+   request of call C.  */
+static int
+tmpl_same_bufs (Req_Template *t, Call *c)
+{
+  int i;
+
+  for (i = 0; i < IE_LEN; ++i)
+    if (t->iov[i].iov_base != c->req.iov[i].iov_base
+	|| t->iov[i].iov_len != c->req.iov[i].iov_len)
+      return 0;
+  return 1;
+}
+
+/* Return non-zero if the reused buffers of the request of call C still
+   hold what template T (made from the same buffers) has for them.  */
+static int
+tmpl_same_reused (Req_Template *t, Call *c)
+{
+  const char *cp = t->data;
+  int i;
+
+  for (i = 0; i < IE_LEN; ++i)
+    {
+      if ((c->req.reused_bufs & (1u << i))
+	  && memcmp (cp, c->req.iov[i].iov_base, c->req.iov[i].iov_len) != 0)
+	return 0;
+      cp += c->req.iov[i].iov_len;
+    }
+  return 1;
+}
+
+/* Return the cache key of the request of call C.  */
+static u_int
+tmpl_key (Call *c)
+{
+  u_int key = 2166136261u;
+  int i;
+
+  for (i = 0; i < IE_LEN; ++i)
+    {
+      key = (key ^ (u_int) (uintptr_t) c->req.iov[i].iov_base) * 16777619u;
+      key = (key ^ (u_int) c->req.iov[i].iov_len) * 16777619u;
+    }
+  return key;
+}
+
+void
+call_serialize_request (Call *c)
+{
+  struct Tmpl_Slot *slot;
+  Req_Template *t;
+  u_int key;
+  size_t len;
+  int i;
+
+  if (c->req.tmpl)
+    {
+      tmpl_dec_ref (c->req.tmpl);
+      c->req.tmpl = 0;
+    }
+
+  len = 0;
+  for (i = 0; i < IE_LEN; ++i)
+    len += c->req.iov[i].iov_len;
+  if (len > MAX_TEMPLATE_LEN)
+    return;
+
+  key = tmpl_key (c);
+  slot = tmpl_cache + key % TEMPLATE_CACHE_SIZE;
+  t = slot->tmpl;
+  if (t && t->key == key && tmpl_same_bufs (t, c))
+    {
+      if (c->req.reused_bufs && !tmpl_same_reused (t, c))
+	{
+	  /* same buffers, different request: not worth caching */
+	  slot->volatile_key = key;
+	  slot->tmpl = 0;
+	  tmpl_dec_ref (t);
+	  return;
+	}
+    }
+  else
+    {
+      if (key == slot->volatile_key)
+	return;
+      if (key != slot->seen_key)
+	{
+	  slot->seen_key = key;
+	  return;
+	}
+
+      t = malloc (sizeof (*t) + len);
+      if (!t)
+	{
+	  fprintf (stderr, "%s.call_serialize_request: %s\n",
+		   prog_name, strerror (errno));
+	  exit (1);
+	}
+      t->ref_count = 1;		/* the cache's reference */
+      t->key = key;
+      memcpy (t->iov, c->req.iov, sizeof (t->iov));
+      t->len = len;
+      for (len = 0, i = 0; i < IE_LEN; ++i)
+	{
+	  if (c->req.iov[i].iov_len == 0)
+	    continue;
+	  memcpy (t->data + len, c->req.iov[i].iov_base,
+		  c->req.iov[i].iov_len);
+	  len += c->req.iov[i].iov_len;
+	}
+      if (slot->tmpl)
+	tmpl_dec_ref (slot->tmpl);
+      slot->tmpl = t;
+    }
+  ++t->ref_count;
+  c->req.tmpl = t;
+  c->req.tmpl_sent = 0;
 }
 
 int
@@ -79,3 +239,51 @@ call_append_request_header (Call *c, const char *hdr, size_t len)
   c->req.num_extra_hdrs = num_hdrs + 1;
   return 0;
 }
+
+HTTP_Method
+call_method_id (const char *method, size_t method_len)
+{
+  switch (method_len)
+    {
+    case 3:
+      if (memcmp (method, "GET", 3) == 0)
+	return HM_GET;
+      if (memcmp (method, "PUT", 3) == 0)
+	return HM_PUT;
+      break;
+
+    case 4:
+      if (memcmp (method, "HEAD", 4) == 0)
+	return HM_HEAD;
+      if (memcmp (method, "POST", 4) == 0)
+	return HM_POST;
+      break;
+
+    case 5:
+      if (memcmp (method, "TRACE", 5) == 0)
+	return HM_TRACE;
+      if (memcmp (method, "PATCH", 5) == 0)
+	return HM_PATCH;
+      break;
+
+    case 6:
+      if (memcmp (method, "DELETE", 6) == 0)
+	return HM_DELETE;
+      if (memcmp (method, "REPORT", 6) == 0)
+	return HM_REPORT;
+      break;
+
+    case 7:
+      if (memcmp (method, "OPTIONS", 7) == 0)
+	return HM_OPTIONS;
+      if (memcmp (method, "CONNECT", 7) == 0)
+	return HM_CONNECT;
+      break;
+
+    case 8:
+      if (memcmp (method, "PROPFIND", 8) == 0)
+	return HM_PROPFIND;
+      break;
+    }
+  return HM_OTHER;
+}
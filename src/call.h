@@ -55,6 +55,36 @@ typedef enum IOV_Element
   }
 IOV_Element;
 
+typedef enum HTTP_Method
+  {
+    HM_GET,
+    HM_HEAD,
+    HM_POST,
+    HM_PUT,
+    HM_DELETE,
+    HM_OPTIONS,
+    HM_TRACE,
+    HM_CONNECT,
+    HM_PATCH,
+    HM_PROPFIND,
+    HM_REPORT,
+    HM_OTHER,		/* any method not listed above */
+    HM_NUM_METHODS
+  }
+HTTP_Method;
+
+/* A request serialized into one contiguous buffer.  Templates are
+   immutable and shared by all calls whose requests are identical.  */
+typedef struct Req_Template
+  {
+    u_int ref_count;
+    u_int key;			/* cache key (see call.c) */
+    struct iovec iov[IE_LEN];	/* the buffers DATA was made from */
+    size_t len;			/* length of DATA */
+    char data[1];		/* the request (LEN bytes) */
+  }
+Req_Template;
+
 /* I call this a "call" because "transaction" is too long and because
    it's basically a remote procedure call consisting of a request that
    is answered by a reply.  */
@@ -71,6 +101,12 @@ typedef struct Call
     struct Call *sendq_next;
     struct Call *recvq_next;
     Time timeout;		/* used for watchdog management */
+    /* When the workload meant to issue the call, or 0 if it was issued
+       in response to an earlier one (see gen/rate.c).  */
+    Time time_intended;
+    /* How late the generator got around to creating it (valid only if
+       TIME_INTENDED is set).  */
+    Time sched_lag;
 
     struct
       {
@@ -83,11 +119,18 @@ typedef struct Call
     struct
       {
 	int version;		/* 0x10000*major + minor */
+	HTTP_Method method_id;	/* identifies iov[IE_METHOD] */
 	u_int num_extra_hdrs;	/* number of additional headers in use */
 	int iov_index;		/* first iov element that has data */
 	size_t size;		/* # of bytes sent */
 	struct iovec iov_saved;	/* saved copy of iov[iov_index] */
 	struct iovec iov[IE_LEN];
+	u_int reused_bufs;	/* iov[] elements marked by call_set_reused() */
+	int content_fd;		/* file iov[IE_CONTENT] maps (or -1) */
+	off_t content_off;	/* where iov[IE_CONTENT] starts in that file */
+	Req_Template *tmpl;	/* IOV serialized (or 0 if too large) */
+	size_t tmpl_sent;	/* # of bytes of TMPL sent so far */
+	const char *stat_class;	/* class for --uri-stats (0 = by URI) */
       }
     req;
 
@@ -120,11 +163,28 @@ extern void call_deinit (Call *c);
    ("\r\n").  */
 extern int call_append_request_header (Call *c, const char *hdr, size_t len);
 
+/* Serialize the request of call C (as described by its iov[]) into
+   c->req.tmpl, reusing a cached template if an identical request was
+   serialized before.  Requests too large or too rare to be worth
+   caching are left to be sent from the iov[] (c->req.tmpl is 0).
+   Requests are taken to be identical when their iov[] points to the
+   same buffers with the same lengths, so buffers must not change
+   while they are in use unless marked with call_set_reused().  */
+extern void call_serialize_request (Call *c);
+
+/* Names of the methods other than HM_OTHER, indexed by HTTP_Method.  */
+extern const char *const call_method_name[HM_OTHER];
+
+/* Return the identifier of the METHOD_LEN byte long method name
+   METHOD.  */
+extern HTTP_Method call_method_id (const char *method, size_t method_len);
+
 #define call_set_method(c, method, method_len)			\
   do								\
     {								\
       c->req.iov[IE_METHOD].iov_base = (caddr_t) method;	\
       c->req.iov[IE_METHOD].iov_len = method_len;		\
+      c->req.method_id = call_method_id (method, method_len);	\
     }								\
   while (0)
 
@@ -149,7 +209,26 @@ extern int call_append_request_header (Call *c, const char *hdr, size_t len);
     {								\
       c->req.iov[IE_CONTENT].iov_base = (caddr_t) content;	\
       c->req.iov[IE_CONTENT].iov_len = content_len;		\
+      c->req.content_fd = -1;					\
     }								\
   while (0)
 
+/* Like call_set_contents(), but CONTENT is a mapping of the file FD
+   starting at offset OFF, so the body may be sent straight from the
+   file.  */
+#define call_set_contents_file(c, content, content_len, fd, off)	\
+  do									\
+    {									\
+      c->req.iov[IE_CONTENT].iov_base = (caddr_t) content;		\
+      c->req.iov[IE_CONTENT].iov_len = content_len;			\
+      c->req.content_fd = fd;						\
+      c->req.content_off = off;						\
+    }									\
+  while (0)
+
+/* Mark the buffer of iov[ELEM] of call C as one that is rewritten (or
+   freed and allocated again) for other requests, so that it may hold
+   different bytes at the same address.  */
+#define call_set_reused(c, elem)	((c)->req.reused_bufs |= 1u << (elem))
+
 #endif /* call_h */
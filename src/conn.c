@@ -52,8 +52,11 @@
 #include <call.h>
 #include <conn.h>
 #include <core.h>
+#include <http.h>
 
 static char *srvbase, *srvend, *srvcurrent;
+static u_int num_servers = 1;
+static Conn *pool_head, *pool_tail;
 
 void
 conn_add_servers(void)
@@ -76,13 +79,52 @@ conn_add_servers(void)
 	close(fd);
 
 	srvend = srvbase + st.st_size;
+	num_servers = 0;
 	for (srvcurrent = srvbase; srvcurrent < srvend; srvcurrent += len + 1) {
 		len = strlen(srvcurrent);
 		core_addr_intern(srvcurrent, len, param.port);
+		++num_servers;
 	}
 	srvcurrent = srvbase;
 }
 
+u_int
+conn_num_servers(void)
+{
+	return num_servers;
+}
+
+/*
+ * Pooled connections were created in server order, so handing them out
+ * first in, first out keeps the rotation over the servers intact.
+ */
+void
+conn_pool_add(Conn *conn)
+{
+	conn->warm_next = 0;
+	if (pool_tail)
+		pool_tail->warm_next = conn;
+	else
+		pool_head = conn;
+	pool_tail = conn;
+}
+
+Conn *
+conn_new(void)
+{
+	Conn *conn;
+
+	while ((conn = pool_head) != 0) {
+		pool_head = conn->warm_next;
+		if (!pool_head)
+			pool_tail = 0;
+		conn->warm_next = 0;
+		if (core_warm_alive(conn))
+			return conn;
+	}
+	return (Conn *) object_new(OBJ_CONN);
+}
+
 void
 conn_init(Conn *conn)
 {
@@ -111,7 +153,6 @@ conn_init(Conn *conn)
 	conn->port = param.port;
 	conn->sd = -1;
 	conn->myport = -1;
-	conn->line.iov_base = conn->line_buf;
 	conn->fqdname_len = strcspn(conn->fqdname,"\r\n"); // Chomp since used in Host header record
 
 #ifdef HAVE_SSL
@@ -122,6 +163,8 @@ conn_init(Conn *conn)
 			exit(-1);
 		}
 
+		SSL_set_app_data(conn->ssl, conn);
+
 		if (param.tls_server_name)
 		{
 			SSL_set_tlsext_host_name(conn->ssl, param.tls_server_name);
@@ -149,7 +192,16 @@ conn_deinit(Conn *conn)
 	assert(!conn->watchdog);
 	conn->state = S_FREE;
 
+	http_release_line(conn);
+
+	if (conn->recv_buf)
+		free(conn->recv_buf);
+	if (conn->recv_map && conn->recv_map != MAP_FAILED)
+		munmap(conn->recv_map, param.bulk_recv);
+
 #ifdef HAVE_SSL
+	if (conn->ssl_early_call)
+		call_dec_ref(conn->ssl_early_call);
 	if (param.use_ssl)
 		SSL_free(conn->ssl);
 #endif
@@ -44,8 +44,9 @@
 
 /* Maximum header line length that we can process properly.  Longer
    lines will be treated as if they were only this long (i.e., they
-   will be truncated).  */
-#define MAX_HDR_LINE_LEN	1024
+   will be truncated).  Line buffers start out much smaller and grow
+   as needed.  */
+#define MAX_HDR_LINE_LEN	(64*1024)
 
 struct Call;
 
@@ -72,13 +73,26 @@ typedef struct Conn
   {
     Object obj;
 
+    /* Fields touched on every I/O event come first: */
     Conn_State state;
-    struct Conn *next;
+    int	sd;			/* socket descriptor */
+    u_int reading : 1;
+    u_int writing : 1;
+    u_int has_body : 1;		/* does reply have a body? */
+    u_int is_chunked : 1;	/* is the reply chunked? */
     struct Call *sendq;		/* calls whose request needs to be sent */
     struct Call *sendq_tail;
     struct Call *recvq;		/* calls waiting for a reply */
     struct Call *recvq_tail;
     struct Timer *watchdog;
+    /* Since replies are read off the socket sequentially, much of the
+       reply-processing related state can be kept here instead of in
+       the reply structure: */
+    size_t content_length;	/* content length (or INF if unknown) */
+    struct iovec line;		/* current (or partial) header line */
+    char *line_buf;		/* holds a line that spans reads */
+    size_t line_size;		/* size of LINE_BUF (0 if none attached) */
+    struct Conn *next;
 
     struct
       {
@@ -92,25 +106,44 @@ typedef struct Conn
     size_t fqdname_len;
     const char *fqdname;	/* fully qualified server name (or 0) */
     int port;			/* server's port (or -1 for default) */
-    int	sd;			/* socket descriptor */
     int myport;			/* local port number or -1 */
     struct local_addr *myaddr;
-    /* Since replies are read off the socket sequentially, much of the
-       reply-processing related state can be kept here instead of in
-       the reply structure: */
-    struct iovec line;		/* buffer used to parse reply headers */
-    size_t content_length;	/* content length (or INF if unknown) */
-    u_int has_body : 1;		/* does reply have a body? */
-    u_int is_chunked : 1;	/* is the reply chunked? */
-    u_int reading : 1;
-    u_int writing : 1;
-    char line_buf[MAX_HDR_LINE_LEN];	/* default line buffer */
+    u_int zerocopy : 1;		/* send large bodies with MSG_ZEROCOPY? */
+    u_int tfo : 1;		/* connected with TCP Fast Open? */
+    u_int zerocopy_pending;	/* MSG_ZEROCOPY sends not yet completed */
+    char *recv_buf;		/* page-aligned --bulk-recv buffer (or 0) */
+    char *recv_map;		/* socket mapped for TCP_ZEROCOPY_RECEIVE */
+    u_int recv_map_misses;	/* mapping attempts in a row that failed */
+    u_int warming : 1;		/* being set up by the warm-up phase? */
+    u_int warm : 1;		/* set up before the test started? */
+    struct Conn *warm_next;	/* next in the pool of warm connections */
+    Time time_intended;		/* when the rate generator meant to create it */
+    Time sched_lag;		/* how late it actually got created */
 
 #ifdef HAVE_SSL
     SSL *ssl;			/* SSL connection info */
+    u_int ktls_send : 1;	/* kernel encrypts what we write()? */
+    u_int ktls_recv : 1;	/* kernel decrypts what we read()? */
+    u_int ssl_offered : 1;	/* handshake offered a cached session? */
+    u_int ssl_early_pending : 1; /* first request still to go out as 0-RTT? */
+    u_int ssl_early_sent : 1;	/* first request went out as 0-RTT data? */
+    u_int ssl_busy : 1;		/* handshake step running on a worker? */
+    Time ssl_handshake_start;	/* when the TLS handshake began */
+    struct Call *ssl_early_call;	/* request being sent as early data */
+    struct Conn *ssl_job_next;	/* next on a handshake worker queue */
+    int ssl_job_result;		/* outcome of the last handshake step */
+    int ssl_busy_sd;		/* socket to close once the step is done */
 #endif
 #ifdef HAVE_EPOLL
     int epoll_added;	/* is fd added into epoll? */
+    u_int epoll_mask;	/* events the fd is registered for */
+    u_int epoll_ready;	/* directions ready without an edge to come */
+    u_int epoll_queued : 1;	/* on the list of pending epoll work? */
+    struct Conn *epoll_next;	/* next connection on that list */
+#endif
+#ifdef HAVE_IO_URING
+    char *ring_buf;		/* buffer of the read in flight */
+    struct Call *ring_call;	/* call of the writev in flight */
 #endif
   }
 Conn;
@@ -121,13 +154,22 @@ extern Conn *conn;
 /* Store the servers to connect to in memory. */
 extern void conn_add_servers (void);
 
+/* Return the number of servers connections are spread over.  */
+extern u_int conn_num_servers (void);
+
+/* Add the established connection C to the pool that conn_new() draws
+   from before it creates new connections.  */
+extern void conn_pool_add (Conn *c);
+
+/* Return a connection from the pool, or a new one if it is empty.  */
+extern Conn *conn_new (void);
+
 /* Initialize the new connection object C.  */
 extern void conn_init (Conn *c);
 
 /* Destroy the connection-specific state in connection object C.  */
 extern void conn_deinit (Conn *c);
 
-#define conn_new()	((Conn *) object_new (OBJ_CONN))
 #define conn_inc_ref(c)	object_inc_ref ((Object *) (c))
 #define conn_dec_ref(c)	object_dec_ref ((Object *) (c))
 
@@ -38,6 +38,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
 #include <signal.h>
 #include <stdio.h>
@@ -45,7 +46,9 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <stdint.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #ifdef HAVE_SYS_SELECT_H
@@ -54,6 +57,20 @@
 #ifdef HAVE_EPOLL
 #include <sys/epoll.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#include <linux/errqueue.h>
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+#define HAVE_ZEROCOPY	1
+#endif
+#endif
+#ifdef HAVE_IO_URING
+#include <poll.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
 
 #ifdef HAVE_KEVENT
 #include <sys/event.h>
@@ -74,6 +91,14 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 
+/*
+ * Linux 6.3 and up; older C libraries don't know it yet.
+ */
+#if defined(__linux__) && defined(IP_BIND_ADDRESS_NO_PORT) && \
+    !defined(IP_LOCAL_PORT_RANGE)
+#define IP_LOCAL_PORT_RANGE	51
+#endif
+
 #include <generic_types.h>
 #include <sys/resource.h>	/* after sys/types.h for BSD (in generic_types.h) */
 
@@ -85,29 +110,63 @@
 #include <core.h>
 #include <localevent.h>
 #include <http.h>
+#ifdef HAVE_SSL
+# include <ssl_cache.h>
+# include <ssl_pool.h>
+#endif
 
 #define HASH_TABLE_SIZE	1024	/* can't have more than this many servers */
 #define MIN_IP_PORT	IPPORT_RESERVED
 #define MAX_IP_PORT	65535
-#define BITSPERLONG	(8*sizeof (u_long))
+#define NUM_IP_PORTS	(MAX_IP_PORT - MIN_IP_PORT + 1)
+#define DISCARD_MAX	(64*1024*1024)	/* max body bytes to drop per recv() */
+#define SEND_BUDGET	(64*1024)	/* max request bytes per writev() */
+#define RECV_MAP_MISSES	8	/* give up mapping after this many misses */
+
+#if !defined(IOV_MAX) || IOV_MAX > 256
+# define SEND_IOV_MAX	256
+#else
+# define SEND_IOV_MAX	IOV_MAX
+#endif
 
+/*
+ * Ports for --hog are handed out in order, and once all have been used
+ * the released ones are reused oldest first, which keeps them out of
+ * TIME_WAIT trouble as long as possible.  The queue of released ports
+ * is only allocated when the first one comes back, and grows (by
+ * doubling) with the number of ports waiting in it, so an address that
+ * never cycles through its whole range stays small.
+ */
 struct local_addr {
 	struct in_addr ip;
-	u_long port_free_map[((MAX_IP_PORT - MIN_IP_PORT + BITSPERLONG)
-		    / BITSPERLONG)];
-	u_long mask;
-	int previous;
+	int next_port;		/* lowest port never handed out */
+	u_short *free_ports;	/* ring of released ports (or NULL) */
+	int free_size;		/* # of slots in free_ports */
+	int free_head;		/* oldest entry in free_ports */
+	int free_count;		/* # of entries in free_ports */
 };
 
 struct address_pool {
 	struct local_addr *addresses;
 	int count;
+	int alloced;
 	int last;
 };
 
 static volatile int      running = 1;
 static int      iteration;
 static u_long   max_burst_len;
+static u_wide   recv_calls;	/* # of system calls receiving replies */
+static u_wide   recv_bytes;	/* # of bytes they received */
+static u_wide   recv_zc_bytes;	/* # of those mapped instead of copied */
+static u_long   tfo_tried;	/* # of connections set up for Fast Open */
+static u_long   tfo_used;	/* # whose request went out in the SYN */
+static u_long   warm_pending;	/* # of warm-up connections not done yet */
+static u_long   warm_established;	/* # of warm-up connections set up */
+static u_long   warm_failed;	/* # of warm-up connections that failed */
+static Time     warm_setup_sum;	/* sum of their connect (+TLS) times */
+static Time     warm_time;	/* how long the warm-up phase took */
+static size_t   page_size;
 #ifdef HAVE_KEVENT
 static int	kq, max_sd = 0;
 #else
@@ -115,13 +174,40 @@ static int	kq, max_sd = 0;
 #define	EPOLL_N_MAX		8192
 static int epoll_fd, max_sd = 0;
 static struct epoll_event *epoll_events;
-static int epoll_timeout;
+/*
+ * Connections whose epoll registration is out of date or, with
+ * --edge-triggered, that have work for a direction already known to be
+ * ready.  Each holds a reference while on the list.
+ */
+static Conn *epoll_list, *epoll_list_tail;
+#else
+#ifdef HAVE_IO_URING
+#define	RING_SQ_ENTRIES		4096
+#define	RING_CQ_ENTRIES		32768
+#define	RING_BUF_SIZE		8193
+static struct ring {
+	int		fd;
+	u_int		sq_tail;	/* next free submission slot */
+	u_int		sq_entries, sq_mask, cq_mask;
+	int		can_wait;	/* kernel takes a wait timeout */
+	u_int	       *sq_khead, *sq_ktail;
+	u_int	       *cq_khead, *cq_ktail;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void	       *free_bufs;	/* recycled read buffers */
+} ring;
+static int max_sd = 0;
 #else
 static fd_set   rdfds, wrfds;
 static int      min_sd = 0x7fffffff, max_sd = 0, alloced_sd_to_conn = 0;
-static struct timeval select_timeout;
 #endif
 #endif
+#endif
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+static int	ssl_wake_fd = -1;	/* readable when handshakes progressed */
+static void	ssl_pool_start(void);
+static void	ssl_pool_complete(void);
+#endif
 static struct sockaddr_in myaddr;
 static struct address_pool myaddrs;
 #ifndef HAVE_KEVENT
@@ -161,19 +247,40 @@ static char     http11req_nohost[] =
 
 enum Syscalls {
 	SC_BIND, SC_CONNECT, SC_READ, SC_SELECT, SC_SOCKET, SC_WRITEV,
-	SC_SSL_READ, SC_SSL_WRITEV, SC_KEVENT,
-	SC_EPOLL_CREATE, SC_EPOLL_CTL, SC_EPOLL_WAIT,
+	SC_SSL_READ, SC_SSL_WRITE, SC_SSL_WRITEV, SC_KEVENT,
+	SC_EPOLL_CREATE, SC_EPOLL_CTL, SC_EPOLL_WAIT, SC_IO_URING_ENTER,
+	SC_SENDFILE, SC_SEND, SC_RECVMSG, SC_ZC_RECEIVE,
 	SC_NUM_SYSCALLS
 };
 
 static const char *const syscall_name[SC_NUM_SYSCALLS] = {
 	"bind", "connct", "read", "select", "socket", "writev",
-	"ssl_read", "ssl_writev", "kevent",
-	"epoll_create", "epoll_ctl", "epoll_wait"
+	"ssl_read", "ssl_write", "ssl_writev", "kevent",
+	"epoll_create", "epoll_ctl", "epoll_wait", "io_uring_enter",
+	"sendfile", "send", "recvmsg", "zc_receive"
 };
 static Time     syscall_time[SC_NUM_SYSCALLS];
 static u_int    syscall_count[SC_NUM_SYSCALLS];
+
+#ifdef HAVE_IO_URING
+/*
+ * Operations queued on the ring are executed by the kernel without a
+ * system call of their own, so they are only counted.
+ */
+# define RING_OP(n)	(++ring_op_count[RO_##n])
+
+enum Ring_Ops {
+	RO_CONNECT, RO_READ, RO_WRITE, RO_WRITEV, RO_POLL, RO_CANCEL,
+	RO_CLOSE, RO_NUM_OPS
+};
+
+static const char *const ring_op_name[RO_NUM_OPS] = {
+	"connect", "read", "write", "writev", "poll", "cancel", "close"
+};
+static u_int    ring_op_count[RO_NUM_OPS];
+#endif
 #else
+# define RING_OP(n)
 # define SYSCALL(n,s)				\
   {						\
     do						\
@@ -185,6 +292,16 @@ static u_int    syscall_count[SC_NUM_SYSCALLS];
   }
 #endif
 
+/*
+ * Whether the connections speak TLS through OpenSSL, which reads and
+ * writes the sockets itself (param.use_ssl exists only with SSL support).
+ */
+#ifdef HAVE_SSL
+# define SSL_USED()	param.use_ssl
+#else
+# define SSL_USED()	0
+#endif
+
 struct hash_entry {
 	const char     *hostname;
 	int             port;
@@ -255,82 +372,132 @@ hash_lookup(const char *server, size_t server_len, int port)
 	return 0;
 }
 
-static int
-lffs(long w)
+static void
+port_put(struct local_addr *addr, int port)
 {
-#ifdef __FreeBSD__
-	return ffsl(w);
-#else
-	int             r;
+	u_short        *ports;
+	int             i, size;
 
-	if (sizeof(w) == sizeof(int))
-		r = ffs(w);
-	else {
-		r = ffs(w);
-#if SIZEOF_LONG > 4
-		if (r == 0) {
-			r = ffs(w >> (8 * sizeof(int)));
-			if (r > 0)
-				r += 8 * sizeof(int);
+	if (addr->free_count == addr->free_size) {
+		/*
+		 * Full (or not there yet): double the ring, moving the
+		 * entries from free_head on to the end of the new one so
+		 * they stay in order.
+		 */
+		size = addr->free_size ? 2 * addr->free_size : 64;
+		if (size > NUM_IP_PORTS)
+			size = NUM_IP_PORTS;
+		assert(size > addr->free_size);
+		ports = realloc(addr->free_ports, size * sizeof(ports[0]));
+		if (!ports) {
+			fprintf(stderr, "%s.port_put: out of memory\n",
+				prog_name);
+			exit(1);
 		}
-#endif
+		i = addr->free_size - addr->free_head;
+		if (i > 0) {
+			memmove(ports + size - i, ports + addr->free_head,
+			    i * sizeof(ports[0]));
+			addr->free_head = size - i;
+		}
+		addr->free_ports = ports;
+		addr->free_size = size;
 	}
-	return r;
-#endif
+	i = addr->free_head + addr->free_count;
+	if (i >= addr->free_size)
+		i -= addr->free_size;
+	addr->free_ports[i] = port;
+	++addr->free_count;
 }
 
-static void
-port_put(struct local_addr *addr, int port)
+static int
+port_get(struct local_addr *addr)
 {
-	int             i, bit;
+	int             port;
+
+	if (addr->next_port <= MAX_IP_PORT)
+		return addr->next_port++;
 
-	port -= MIN_IP_PORT;
-	i = port / BITSPERLONG;
-	bit = port % BITSPERLONG;
-	addr->port_free_map[i] |= (1UL << bit);
+	if (addr->free_count == 0) {
+		if (DBG > 0)
+			fprintf(stderr,
+				"%s.port_get: Yikes! I'm out of port numbers!\n",
+				prog_name);
+		return -1;
+	}
+	port = addr->free_ports[addr->free_head];
+	if (++addr->free_head == addr->free_size)
+		addr->free_head = 0;
+	--addr->free_count;
+	return port;
 }
 
-static int
-port_get(struct local_addr *addr)
+static void conn_failure(Conn * s, int err);
+
+/*
+ * Book-keeping for a connection of the warm-up phase that reached
+ * state ET.  Connections that make it go to the pool; those that fail
+ * are closed and destroyed with their warming flag still set, so that
+ * the generators can tell them from their own.
+ */
+static void
+warm_done(Conn * s, Event_Type et)
 {
-	int             port, bit, i;
+	socklen_t       len;
+	int             err;
 
-	i = addr->previous;
-	if ((addr->port_free_map[i] & addr->mask) == 0) {
-		do {
-			++i;
-			if (i >= NELEMS(addr->port_free_map))
-				i = 0;
-			if (i == addr->previous) {
-				if (DBG > 0)
-					fprintf(stderr,
-						"%s.port_get: Yikes! I'm out of port numbers!\n",
-						prog_name);
-				return -1;
-			}
+	switch (et) {
+	case EV_CONN_CONNECTED:
+		/*
+		 * A refused connect shows up as writability too; a pooled
+		 * connection must really be up.
+		 */
+		len = sizeof(err);
+		if (getsockopt(s->sd, SOL_SOCKET, SO_ERROR, &err, &len) == 0
+		    && err != 0) {
+			conn_failure(s, err);
+			return;
 		}
-		while (addr->port_free_map[i] == 0);
-		addr->mask = ~0UL;
-	}
-	addr->previous = i;
+		warm_setup_sum += timer_now() - s->basic.time_connect_start;
+		++warm_established;
+		s->warming = 0;
+		s->warm = 1;
+		conn_pool_add(s);
+		break;
 
-	bit = lffs(addr->port_free_map[i] & addr->mask) - 1;
-	if (bit >= BITSPERLONG - 1)
-		addr->mask = 0;
-	else
-		addr->mask = ~((1UL << (bit + 1)) - 1);
-	addr->port_free_map[i] &= ~(1UL << bit);
-	port = bit + i * BITSPERLONG + MIN_IP_PORT;
-	return port;
+	case EV_CONN_FAILED:
+	case EV_CONN_TIMEOUT:
+		++warm_failed;
+		break;
+
+	default:
+		return;
+	}
+	if (--warm_pending == 0)
+		running = 0;
 }
 
+/*
+ * Signals ET for connection S.  Nobody but the pool knows about
+ * connections that are still warming up, so they are left out.
+ */
 static void
-conn_failure(Conn * s, int err)
+conn_signal(Conn * s, Event_Type et, long val)
 {
 	Any_Type        arg;
 
-	arg.l = err;
-	event_signal(EV_CONN_FAILED, (Object *) s, arg);
+	if (s->warming) {
+		warm_done(s, et);
+		return;
+	}
+	arg.l = val;
+	event_signal(et, (Object *) s, arg);
+}
+
+static void
+conn_failure(Conn * s, int err)
+{
+	conn_signal(s, EV_CONN_FAILED, err);
 
 	core_close(s);
 }
@@ -364,14 +531,321 @@ conn_timeout(struct Timer *t, Any_Type arg)
 		}
 	}
 
-	arg.l = 0;
-	event_signal(EV_CONN_TIMEOUT, (Object *) s, arg);
+	conn_signal(s, EV_CONN_TIMEOUT, 0);
 
 	core_close(s);
 }
 
 enum IO_DIR { READ, WRITE };
 
+#ifdef HAVE_IO_URING
+/*
+ * A ring operation on behalf of a connection carries the connection
+ * pointer with the direction it was submitted for in the low bits;
+ * operations whose user_data is untagged complete silently.  The poll
+ * for finished handshake steps is tagged with both bits and no pointer.
+ */
+#define	RING_TAG(s, dir)	((__u64) (uintptr_t) (s) | ((dir) + 1))
+#define	RING_TAG_MASK		3
+#define	RING_TAG_WAKE		RING_TAG_MASK
+
+static void
+ring_init(void)
+{
+	struct io_uring_params p;
+	size_t          sq_size, cq_size;
+	char           *sq, *cq;
+	u_int          *array, i;
+
+	memset(&p, 0, sizeof(p));
+	p.flags = IORING_SETUP_CQSIZE;
+	p.cq_entries = RING_CQ_ENTRIES;
+	ring.fd = syscall(__NR_io_uring_setup, RING_SQ_ENTRIES, &p);
+	if (ring.fd < 0) {
+		fprintf(stderr, "%s: failed to create io_uring: %s\n",
+		    prog_name, strerror(errno));
+		exit(1);
+	}
+
+	sq_size = p.sq_off.array + p.sq_entries * sizeof(u_int);
+	cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if ((p.features & IORING_FEAT_SINGLE_MMAP) && cq_size > sq_size)
+		sq_size = cq_size;
+	sq = mmap(0, sq_size, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		cq = sq;
+	else
+		cq = mmap(0, cq_size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+	ring.sqes = mmap(0, p.sq_entries * sizeof(struct io_uring_sqe),
+	    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd,
+	    IORING_OFF_SQES);
+	if (sq == MAP_FAILED || cq == MAP_FAILED || ring.sqes == MAP_FAILED) {
+		fprintf(stderr, "%s: failed to map io_uring: %s\n",
+		    prog_name, strerror(errno));
+		exit(1);
+	}
+
+	ring.sq_khead = (u_int *) (sq + p.sq_off.head);
+	ring.sq_ktail = (u_int *) (sq + p.sq_off.tail);
+	ring.sq_mask = *(u_int *) (sq + p.sq_off.ring_mask);
+	ring.sq_entries = p.sq_entries;
+	ring.sq_tail = *ring.sq_ktail;
+
+	/* submission slots are always used in ring order */
+	array = (u_int *) (sq + p.sq_off.array);
+	for (i = 0; i < p.sq_entries; ++i)
+		array[i] = i;
+
+	ring.cq_khead = (u_int *) (cq + p.cq_off.head);
+	ring.cq_ktail = (u_int *) (cq + p.cq_off.tail);
+	ring.cq_mask = *(u_int *) (cq + p.cq_off.ring_mask);
+	ring.cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+	ring.can_wait = (p.features & IORING_FEAT_EXT_ARG) != 0;
+}
+
+/*
+ * Submit everything queued since the last call, then wait up to TIMEOUT
+ * seconds (forever if negative) for a completion.  Kernels that cannot
+ * bound the wait are only polled.
+ */
+static void
+ring_enter(Time timeout)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	u_int           to_submit, min_complete = 0;
+	u_int           flags = IORING_ENTER_GETEVENTS;
+	int             n;
+
+	memset(&arg, 0, sizeof(arg));
+	if (timeout != 0 && ring.can_wait) {
+		if (timeout > 0) {
+			ts.tv_sec = (long long) timeout;
+			ts.tv_nsec = (long long) ((timeout - ts.tv_sec) * 1e9);
+			arg.ts = (uintptr_t) &ts;
+		}
+		min_complete = 1;
+		flags |= IORING_ENTER_EXT_ARG;
+	}
+
+	__atomic_store_n(ring.sq_ktail, ring.sq_tail, __ATOMIC_RELEASE);
+	to_submit = ring.sq_tail - __atomic_load_n(ring.sq_khead,
+	    __ATOMIC_ACQUIRE);
+	SYSCALL(IO_URING_ENTER,
+	    n = syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete,
+		flags, min_complete ? &arg : NULL, sizeof(arg)));
+	if (n < 0 && errno != EAGAIN && errno != EBUSY && errno != ETIME) {
+		fprintf(stderr, "%s.ring_enter: io_uring_enter failed: %s\n",
+		    prog_name, strerror(errno));
+		exit(1);
+	}
+}
+
+static struct io_uring_sqe *
+ring_get_sqe(void)
+{
+	struct io_uring_sqe *sqe;
+
+	while (ring.sq_tail - __atomic_load_n(ring.sq_khead,
+	    __ATOMIC_ACQUIRE) >= ring.sq_entries)
+		ring_enter(0);
+
+	sqe = &ring.sqes[ring.sq_tail++ & ring.sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+static char *
+ring_buf_get(void)
+{
+	char           *buf = ring.free_bufs;
+
+	if (buf)
+		ring.free_bufs = *(void **) buf;
+	else if (!(buf = malloc(RING_BUF_SIZE))) {
+		fprintf(stderr, "%s.ring_buf_get: %s\n", prog_name,
+		    strerror(errno));
+		exit(1);
+	}
+	return buf;
+}
+
+static void
+ring_buf_put(char *buf)
+{
+	*(void **) buf = ring.free_bufs;
+	ring.free_bufs = buf;
+}
+
+static void
+ring_connect(Conn * s, struct sockaddr_in *sin)
+{
+	struct io_uring_sqe *sqe;
+
+	sqe = ring_get_sqe();
+	sqe->opcode = IORING_OP_CONNECT;
+	sqe->fd = s->sd;
+	sqe->addr = (uintptr_t) sin;
+	sqe->off = sizeof(*sin);
+	sqe->user_data = RING_TAG(s, WRITE);
+	RING_OP(CONNECT);
+
+	conn_inc_ref(s);
+	s->writing = 1;
+}
+
+/*
+ * Queue the I/O that set_active() asks for.  SSL does its own reads
+ * and writes, so for SSL connections we only wait for readiness.
+ */
+static void
+ring_submit_io(Conn * s, enum IO_DIR dir)
+{
+	struct io_uring_sqe *sqe;
+	Call           *call;
+
+	if (dir == WRITE && !SSL_USED()) {
+		call = s->sendq;
+		sqe = ring_get_sqe();
+		if (call->req.tmpl) {
+			sqe->opcode = IORING_OP_WRITE;
+			sqe->addr = (uintptr_t) (call->req.tmpl->data
+			    + call->req.tmpl_sent);
+			sqe->len = call->req.tmpl->len - call->req.tmpl_sent;
+			RING_OP(WRITE);
+		} else {
+			sqe->opcode = IORING_OP_WRITEV;
+			sqe->addr = (uintptr_t) (call->req.iov
+			    + call->req.iov_index);
+			sqe->len = NELEMS(call->req.iov) - call->req.iov_index;
+			RING_OP(WRITEV);
+		}
+
+		call_inc_ref(call);
+		s->ring_call = call;
+	} else if (dir == READ && !SSL_USED()) {
+		s->ring_buf = ring_buf_get();
+
+		sqe = ring_get_sqe();
+		sqe->opcode = IORING_OP_READ;
+		sqe->addr = (uintptr_t) s->ring_buf;
+		sqe->len = RING_BUF_SIZE - 1;
+		RING_OP(READ);
+	} else {
+		sqe = ring_get_sqe();
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->poll32_events = dir == WRITE ? POLLOUT : POLLIN;
+		RING_OP(POLL);
+	}
+	sqe->fd = s->sd;
+	sqe->user_data = RING_TAG(s, dir);
+	conn_inc_ref(s);
+}
+
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+/*
+ * Wait (once) for the handshake workers to report progress.
+ */
+static void
+ring_poll_wake(void)
+{
+	struct io_uring_sqe *sqe;
+
+	sqe = ring_get_sqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = ssl_wake_fd;
+	sqe->poll32_events = POLLIN;
+	sqe->user_data = RING_TAG_WAKE;
+	RING_OP(POLL);
+}
+#endif
+
+/*
+ * Cancel whatever is still in flight for S and have the ring close SD.
+ * Closing through the ring keeps the descriptor from being reused
+ * before the operations queued ahead of the close have been submitted.
+ */
+static void
+ring_close(Conn * s, int sd)
+{
+	struct io_uring_sqe *sqe;
+	int             dir;
+
+	for (dir = READ; dir <= WRITE; ++dir) {
+		if (dir == READ ? !s->reading : !s->writing)
+			continue;
+		sqe = ring_get_sqe();
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->addr = RING_TAG(s, dir);
+		RING_OP(CANCEL);
+	}
+
+	sqe = ring_get_sqe();
+	sqe->opcode = IORING_OP_CLOSE;
+	sqe->fd = sd;
+	RING_OP(CLOSE);
+}
+#endif
+
+#ifdef HAVE_EPOLL
+static void
+epoll_queue(Conn * s)
+{
+	if (s->epoll_queued)
+		return;
+	s->epoll_queued = 1;
+	conn_inc_ref(s);
+	s->epoll_next = 0;
+	if (epoll_list)
+		epoll_list_tail->epoll_next = s;
+	else
+		epoll_list = s;
+	epoll_list_tail = s;
+}
+
+/*
+ * Registers S for EVENTS, unless it already is.
+ */
+static void
+epoll_register(Conn * s, u_int events)
+{
+	struct epoll_event ev;
+	int error;
+
+	if (s->epoll_added && s->epoll_mask == events)
+		return;
+
+	ev.events = events;
+	ev.data.ptr = s;
+	SYSCALL(EPOLL_CTL,
+	    error = epoll_ctl(epoll_fd, s->epoll_added ? EPOLL_CTL_MOD :
+		EPOLL_CTL_ADD, s->sd, &ev));
+	if (error < 0) {
+		fprintf(stderr, "%s: epoll_ctl failed: %s\n", prog_name,
+		    strerror(errno));
+		exit(1);
+	}
+	s->epoll_added = 1;
+	s->epoll_mask = events;
+}
+#endif
+
+/*
+ * Notes that S has nothing left to read or no room left to write in
+ * direction DIR.  With --edge-triggered, S then waits for the next edge
+ * before trying again.
+ */
+static void
+clear_ready(Conn * s, enum IO_DIR dir)
+{
+#ifdef HAVE_EPOLL
+	s->epoll_ready &= ~(1 << dir);
+#endif
+}
+
 static void
 clear_active(Conn * s, enum IO_DIR dir)
 {
@@ -388,21 +862,23 @@ clear_active(Conn * s, enum IO_DIR dir)
 	}
 #else
 #ifdef HAVE_EPOLL
-	struct epoll_event ev;
-	int error;
-
-	if (dir == WRITE)
-		ev.events = EPOLLIN;
-	else
-		ev.events = EPOLLOUT;
-	ev.data.ptr = s;
-
-	error = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sd, &ev);
-	if (error < 0) {
-		error = errno;
-		fprintf(stderr, "failed to EPOLL_CTL_DEL\n");
-		exit(1);
-	}
+	/*
+	 * Level-triggered registrations are brought up to date just
+	 * before waiting, so that flipping back and forth between reading
+	 * and writing costs at most one epoll_ctl() per wait.  With
+	 * --edge-triggered, both directions stay registered throughout.
+	 */
+	(void) sd;
+	if (!param.edge_triggered)
+		epoll_queue(s);
+#else
+#ifdef HAVE_IO_URING
+	/*
+	 * Ring operations are one-shot: one still in flight completes on
+	 * its own and is simply not resubmitted.
+	 */
+	(void) sd;
+	return;
 #else
 	fd_set *	fdset;
 	
@@ -412,6 +888,7 @@ clear_active(Conn * s, enum IO_DIR dir)
 		fdset = &rdfds;
 	FD_CLR(sd, fdset);
 #endif
+#endif
 #endif
 	if (dir == WRITE)
 		s->writing = 0;
@@ -437,26 +914,16 @@ set_active(Conn * s, enum IO_DIR dir)
 	}
 #else
 #ifdef HAVE_EPOLL
-	struct epoll_event ev;
-	int error;
-
-	if (dir == WRITE)
-		ev.events = EPOLLOUT;
-	else
-		ev.events = EPOLLIN;
-	ev.data.ptr = s;
-
-	if (s->epoll_added)
-		error = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sd, &ev);
-	else {
-		error = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sd, &ev);
-		s->epoll_added = 1;
-	}
-	if (error < 0) {
-		error = errno;
-		fprintf(stderr, "failed to EPOLL_CTL_MOD\n");
-		exit(1);
-	}
+	if (!param.edge_triggered)
+		epoll_queue(s);
+	else if (!s->epoll_added)
+		epoll_register(s, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+	else if (s->epoll_ready & (1 << dir))
+		epoll_queue(s);		/* no edge will come for this */
+#else
+#ifdef HAVE_IO_URING
+	if (dir == WRITE ? !s->writing : !s->reading)
+		ring_submit_io(s, dir);
 #else
 	fd_set *	fdset;
 	
@@ -468,6 +935,7 @@ set_active(Conn * s, enum IO_DIR dir)
 	if (sd < min_sd)
 		min_sd = sd;
 #endif
+#endif
 #endif
 	if (sd >= max_sd)
 		max_sd = sd;
@@ -492,68 +960,59 @@ set_active(Conn * s, enum IO_DIR dir)
 	}
 }
 
-static void
-do_send(Conn * conn)
+enum Body_Mode {
+	BODY_COPY, BODY_SENDFILE, BODY_ZEROCOPY
+};
+
+/*
+ * Decide how the body of CALL goes out: straight from the file it was
+ * mapped from, pinned with MSG_ZEROCOPY if it is at least --zerocopy
+ * bytes, or copied by writev() along with everything else.
+ */
+static enum Body_Mode
+body_mode(Conn * conn, Call * call)
+{
+	size_t          len = call->req.iov[IE_CONTENT].iov_len;
+
+	if (call->req.tmpl || len == 0)
+		return BODY_COPY;
+#ifdef HAVE_SYS_SENDFILE_H
+	if (call->req.content_fd >= 0)
+		return BODY_SENDFILE;
+#endif
+#ifdef HAVE_ZEROCOPY
+	if (conn->zerocopy && len >= param.zerocopy)
+		return BODY_ZEROCOPY;
+#endif
+	return BODY_COPY;
+}
+
+/*
+ * Account for NSENT more bytes of CALL's request having been written.
+ * Returns non-zero if the next request on the connection can be sent
+ * right away.
+ */
+static int
+send_progress(Conn * conn, Call * call, size_t nsent)
 {
-	int             async_errno;
-	socklen_t       len;
 	struct iovec   *iovp;
-	int             sd = conn->sd;
-	ssize_t         nsent = 0;
 	Any_Type        arg;
-	Call           *call;
-
-	while (1) {
-		call = conn->sendq;
-		assert(call);
+	int             more;
 
+	/*
+	 * Report the request as its first bytes go out (and only then,
+	 * however many writes it takes): 
+	 */
+	if (call->req.size == 0 && nsent > 0) {
 		arg.l = 0;
 		event_signal(EV_CALL_SEND_RAW_DATA, (Object *) call, arg);
+	}
+	call->req.size += nsent;
 
-#ifdef HAVE_SSL
-		if (param.use_ssl) {
-			extern ssize_t  SSL_writev(SSL *, const struct iovec *,
-						   int);
-			SYSCALL(SSL_WRITEV, nsent =
-				SSL_writev(conn->ssl,
-					   call->req.iov + call->req.iov_index,
-					   (NELEMS(call->req.iov)
-					    - call->req.iov_index)));
-		} else
-#endif
-		{
-			SYSCALL(WRITEV,
-				nsent =
-				writev(sd, call->req.iov + call->req.iov_index,
-				       (NELEMS(call->req.iov)
-					- call->req.iov_index)));
-		}
-
-		if (DBG > 0)
-			fprintf(stderr, "do_send.%lu: wrote %ld bytes on %p\n",
-				call->id, (long) nsent, conn);
-
-		if (nsent < 0) {
-			if (errno == EAGAIN)
-				return;
-
-			len = sizeof(async_errno);
-			if (getsockopt
-			    (sd, SOL_SOCKET, SO_ERROR, &async_errno, &len) == 0
-			    && async_errno != 0)
-				errno = async_errno;
-
-			if (DBG > 0)
-				fprintf(stderr,
-					"%s.do_send: writev() failed: %s\n",
-					prog_name, strerror(errno));
-
-			conn_failure(conn, errno);
-			return;
-		}
-
-		call->req.size += nsent;
-
+	if (call->req.tmpl) {
+		call->req.tmpl_sent += nsent;
+		more = call->req.tmpl_sent < call->req.tmpl->len;
+	} else {
 		iovp = call->req.iov + call->req.iov_index;
 		while (iovp < call->req.iov + NELEMS(call->req.iov)) {
 			if (nsent < iovp->iov_len) {
@@ -573,59 +1032,330 @@ do_send(Conn * conn)
 			}
 		}
 		call->req.iov_index = iovp - call->req.iov;
-		if (call->req.iov_index < NELEMS(call->req.iov)) {
+		more = call->req.iov_index < NELEMS(call->req.iov);
+	}
+	if (more) {
+		/*
+		 * there are more header bytes to write 
+		 */
+		call->timeout =
+		    param.timeout ? timer_now() + param.timeout : 0.0;
+		if (call->req.iov_index == IE_CONTENT
+		    && call->req.iov[IE_CONTENT].iov_base
+		    == call->req.iov_saved.iov_base
+		    && body_mode(conn, call) != BODY_COPY)
+			return 1;	/* headers are out, body goes next */
+		clear_ready(conn, WRITE);	/* short write: socket is full */
+		set_active(conn, WRITE);
+		return 0;
+	}
+
+	/*
+	 * we're done with sending this request 
+	 */
+	conn->sendq = call->sendq_next;
+	if (!conn->sendq) {
+		conn->sendq_tail = 0;
+		clear_active(conn, WRITE);
+	}
+	arg.l = 0;
+	event_signal(EV_CALL_SEND_STOP, (Object *) call, arg);
+	if (conn->state >= S_CLOSING) {
+		call_dec_ref(call);
+		return 0;
+	}
+
+	/*
+	 * get ready to receive matching reply (note that we
+	 * implicitly pass on the reference to the call from the sendq 
+	 * to the recvq): 
+	 */
+	call->recvq_next = 0;
+	if (!conn->recvq)
+		conn->recvq = conn->recvq_tail = call;
+	else {
+		conn->recvq_tail->recvq_next = call;
+		conn->recvq_tail = call;
+	}
+	call->timeout = param.timeout + param.think_timeout;
+	if (call->timeout > 0.0)
+		call->timeout += timer_now();
+	set_active(conn, READ);
+	if (conn->state < S_REPLY_STATUS)
+		conn->state = S_REPLY_STATUS;	/* expecting reply
+						 * status */
+
+	if (!conn->sendq)
+		return 0;
+
+	arg.l = 0;
+	event_signal(EV_CALL_SEND_START, (Object *) conn->sendq, arg);
+	return conn->state < S_CLOSING;
+}
+
+static void
+send_failure(Conn * conn)
+{
+	int             async_errno;
+	socklen_t       len;
+
+	len = sizeof(async_errno);
+	if (getsockopt
+	    (conn->sd, SOL_SOCKET, SO_ERROR, &async_errno, &len) == 0
+	    && async_errno != 0)
+		errno = async_errno;
+
+	if (DBG > 0)
+		fprintf(stderr,
+			"%s.do_send: writev() failed: %s\n",
+			prog_name, strerror(errno));
+
+	conn_failure(conn, errno);
+}
+
+/*
+ * Return the number of bytes of CALL's request that remain to be sent.
+ */
+static size_t
+send_remaining(Call * call)
+{
+	size_t          len;
+	int             i;
+
+	if (call->req.tmpl)
+		return call->req.tmpl->len - call->req.tmpl_sent;
+	len = 0;
+	for (i = call->req.iov_index; i < NELEMS(call->req.iov); ++i)
+		len += call->req.iov[i].iov_len;
+	return len;
+}
+
+#ifdef HAVE_ZEROCOPY
+/*
+ * Collect the completions of CONN's MSG_ZEROCOPY sends from the socket's
+ * error queue.  Bodies are never modified, so there is no buffer to
+ * release; but if the kernel ended up copying anyway (as it does over
+ * loopback), pinning pages only costs extra and zero-copy is turned off
+ * for the connection.
+ */
+static void
+zerocopy_reap(Conn * conn)
+{
+	char            control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct sock_extended_err *serr;
+	struct cmsghdr *cm;
+	struct msghdr   msg;
+	u_int           done;
+	ssize_t         n;
+
+	while (conn->zerocopy_pending > 0) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		SYSCALL(RECVMSG, n = recvmsg(conn->sd, &msg, MSG_ERRQUEUE));
+		if (n < 0)
+			return;	/* nothing (more) completed yet */
+
+		for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+			serr = (struct sock_extended_err *) CMSG_DATA(cm);
+			if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
 			/*
-			 * there are more header bytes to write 
+			 * sends number ee_info through ee_data completed 
 			 */
-			call->timeout =
-			    param.timeout ? timer_now() + param.timeout : 0.0;
-			set_active(conn, WRITE);
-			return;
+			done = serr->ee_data - serr->ee_info + 1;
+			if (done > conn->zerocopy_pending)
+				done = conn->zerocopy_pending;
+			conn->zerocopy_pending -= done;
+			if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				conn->zerocopy = 0;
 		}
+	}
+}
+#endif
+
+/*
+ * Send (part of) the body of CALL, whose headers are out already, the
+ * way body_mode() chose.  Returns what the system call did.
+ */
+static ssize_t
+send_body(Conn * conn, Call * call, enum Body_Mode mode)
+{
+	struct iovec   *iov = call->req.iov + IE_CONTENT;
+	ssize_t         nsent = -1;
+#ifdef HAVE_SYS_SENDFILE_H
+	off_t           off;
 
+	if (mode == BODY_SENDFILE) {
 		/*
-		 * we're done with sending this request 
+		 * iov_saved holds the body as it was before any of it was
+		 * sent.
 		 */
-		conn->sendq = call->sendq_next;
-		if (!conn->sendq) {
-			conn->sendq_tail = 0;
-			clear_active(conn, WRITE);
+		off = call->req.content_off + ((char *) iov->iov_base
+		    - (char *) call->req.iov_saved.iov_base);
+		SYSCALL(SENDFILE, nsent = sendfile(conn->sd,
+			call->req.content_fd, &off, iov->iov_len));
+		if (nsent == 0) {
+			errno = EIO;	/* the file shrank under us */
+			nsent = -1;
 		}
-		arg.l = 0;
-		event_signal(EV_CALL_SEND_STOP, (Object *) call, arg);
-		if (conn->state >= S_CLOSING) {
-			call_dec_ref(call);
-			return;
-		}
-
+		return nsent;
+	}
+#endif
+#ifdef HAVE_ZEROCOPY
+	SYSCALL(SEND, nsent = send(conn->sd, iov->iov_base, iov->iov_len,
+		MSG_ZEROCOPY));
+	if (nsent >= 0)
+		++conn->zerocopy_pending;
+	else if (errno == ENOBUFS) {
 		/*
-		 * get ready to receive matching reply (note that we
-		 * implicitly pass on the reference to the call from the sendq 
-		 * to the recvq): 
+		 * Too many pages pinned already: copy this part.
 		 */
-		call->recvq_next = 0;
-		if (!conn->recvq)
-			conn->recvq = conn->recvq_tail = call;
+		SYSCALL(SEND, nsent = send(conn->sd, iov->iov_base,
+			iov->iov_len, 0));
+	}
+#endif
+	return nsent;
+}
+
+/*
+ * Collect the unsent parts of as many queued requests as fit into IOV
+ * (which has room for SEND_IOV_MAX elements) and SEND_BUDGET bytes, so
+ * that pipelined requests go out with a single writev().  Returns the
+ * number of elements used.
+ */
+static int
+send_gather(Conn * conn, struct iovec *iov)
+{
+	struct iovec   *src, *end;
+	size_t          bytes = 0;
+	Call           *call;
+	int             n = 0, body_left = 0;
+
+	for (call = conn->sendq; call && bytes < SEND_BUDGET && !body_left;
+	    call = call->sendq_next) {
+		if (call->req.tmpl) {
+			src = 0;
+			end = 0;
+			if (n >= SEND_IOV_MAX)
+				break;
+		} else {
+			src = call->req.iov + call->req.iov_index;
+			end = call->req.iov + NELEMS(call->req.iov);
+			if (body_mode(conn, call) != BODY_COPY) {
+				/*
+				 * the body goes out on its own 
+				 */
+				end = call->req.iov + IE_CONTENT;
+				body_left = 1;
+			}
+			if (n > 0 && n + (end - src) > SEND_IOV_MAX)
+				break;
+		}
+
+		if (call->req.tmpl) {
+			iov[n].iov_base = call->req.tmpl->data
+			    + call->req.tmpl_sent;
+			iov[n].iov_len = call->req.tmpl->len
+			    - call->req.tmpl_sent;
+			bytes += iov[n++].iov_len;
+		} else
+			for (; src < end; ++src)
+				if (src->iov_len > 0) {
+					iov[n++] = *src;
+					bytes += src->iov_len;
+				}
+	}
+	return n;
+}
+
+/*
+ * Spread NSENT bytes written from the front of the send queue over the
+ * calls they belong to.  Returns non-zero if more can be sent right
+ * away.
+ */
+static int
+send_spread(Conn * conn, size_t nsent)
+{
+	Call           *call;
+	size_t          n;
+	int             more;
+
+	do {
+		call = conn->sendq;
+		n = send_remaining(call);
+		if (n > nsent)
+			n = nsent;
+		nsent -= n;
+		more = send_progress(conn, call, n);
+	} while (more && nsent > 0);
+	return more;
+}
+
+static void
+do_send(Conn * conn)
+{
+	struct iovec    iov[SEND_IOV_MAX];
+	int             sd = conn->sd;
+	ssize_t         nsent = 0;
+	enum Body_Mode  mode;
+	Call           *call;
+
+#ifdef HAVE_ZEROCOPY
+	if (conn->zerocopy_pending > 0)
+		zerocopy_reap(conn);
+#endif
+	do {
+		call = conn->sendq;
+		assert(call);
+
+#ifdef HAVE_SSL
+		if (param.use_ssl && !conn->ktls_send) {
+			extern ssize_t  SSL_writev(SSL *, const struct iovec *,
+						   int);
+
+			/*
+			 * SSL_write() must be retried with the same data, so
+			 * SSL requests are sent one at a time.
+			 */
+			if (call->req.tmpl) {
+				SYSCALL(SSL_WRITE, nsent =
+					SSL_write(conn->ssl,
+						  call->req.tmpl->data
+						  + call->req.tmpl_sent,
+						  call->req.tmpl->len
+						  - call->req.tmpl_sent));
+			} else {
+				SYSCALL(SSL_WRITEV, nsent =
+					SSL_writev(conn->ssl,
+						   call->req.iov
+						   + call->req.iov_index,
+						   (NELEMS(call->req.iov)
+						    - call->req.iov_index)));
+			}
+		} else
+#endif
+		if (call->req.iov_index == IE_CONTENT
+		    && (mode = body_mode(conn, call)) != BODY_COPY)
+			nsent = send_body(conn, call, mode);
 		else {
-			conn->recvq_tail->recvq_next = call;
-			conn->recvq_tail = call;
+			SYSCALL(WRITEV,
+				nsent = writev(sd, iov,
+					       send_gather(conn, iov)));
 		}
-		call->timeout = param.timeout + param.think_timeout;
-		if (call->timeout > 0.0)
-			call->timeout += timer_now();
-		set_active(conn, READ);
-		if (conn->state < S_REPLY_STATUS)
-			conn->state = S_REPLY_STATUS;	/* expecting reply
-							 * status */
-
-		if (!conn->sendq)
-			return;
 
-		arg.l = 0;
-		event_signal(EV_CALL_SEND_START, (Object *) conn->sendq, arg);
-		if (conn->state >= S_CLOSING)
+		if (DBG > 0)
+			fprintf(stderr, "do_send.%lu: wrote %ld bytes on %p\n",
+				call->id, (long) nsent, conn);
+
+		if (nsent < 0) {
+			if (errno != EAGAIN)
+				send_failure(conn);
+			else
+				clear_ready(conn, WRITE);
 			return;
-	}
+		}
+	} while (send_spread(conn, nsent));
 }
 
 static void
@@ -648,27 +1378,22 @@ recv_done(Call * call)
 	call_dec_ref(call);
 }
 
+/*
+ * Process the NREAD bytes read into BUF, which must have room for a
+ * terminating '\0'.  A negative NREAD means that the read failed with
+ * SAVED_ERRNO.
+ */
 static void
-do_recv(Conn * s)
+recv_data(Conn * s, char *buf, ssize_t nread, int saved_errno)
 {
-	char           *cp, buf[8193];
+	char           *cp;
 	Call           *c = s->recvq;
-	int             i, saved_errno;
-	ssize_t         nread = 0;
+	int             i;
 	size_t          buf_len;
 
 	assert(c);
 
-#ifdef HAVE_SSL
-	if (param.use_ssl) {
-		SYSCALL(SSL_READ,
-			nread = SSL_read(s->ssl, buf, sizeof(buf) - 1));
-	} else
-#endif
-	{
-		SYSCALL(READ, nread = read(s->sd, buf, sizeof(buf) - 1));
-	}
-	saved_errno = errno;
+	++recv_calls;
 	if (nread <= 0) {
 		if (DBG > 0) {
 			fprintf(stderr,
@@ -684,6 +1409,8 @@ do_recv(Conn * s)
 		if (nread < 0) {
 			if (saved_errno != EAGAIN)
 				conn_failure(s, saved_errno);
+			else
+				clear_ready(s, READ);
 		} else if (s->state != S_REPLY_DATA)
 			conn_failure(s, ECONNRESET);
 		else {
@@ -693,6 +1420,7 @@ do_recv(Conn * s)
 		}
 		return;
 	}
+	recv_bytes += nread;
 	buf[nread] = '\0';	/* ensure buffer is '\0' terminated */
 
 	if (DBG > 3) {
@@ -750,6 +1478,176 @@ do_recv(Conn * s)
 		set_active(c->conn, READ);
 }
 
+#if defined(__linux__) && defined(MSG_TRUNC)
+/*
+ * Consume up to LEN bytes of the reply body without copying them: on
+ * Linux, MSG_TRUNC makes TCP drop the data instead of returning it.
+ */
+static void
+do_discard(Conn * s, size_t len)
+{
+	Call           *c = s->recvq;
+	ssize_t         nread;
+
+	if (len > DISCARD_MAX)
+		len = DISCARD_MAX;
+	SYSCALL(READ, nread = recv(s->sd, 0, len, MSG_TRUNC));
+	if (nread <= 0) {
+		recv_data(s, 0, nread, errno);
+		return;
+	}
+	++recv_calls;
+	recv_bytes += nread;
+	if ((size_t) nread < len)
+		clear_ready(s, READ);	/* drained the socket */
+
+	http_discard_reply_bytes(c, nread);
+	if (s->state == S_REPLY_DONE) {
+		recv_done(c);
+		if (s->state >= S_CLOSING)
+			return;
+		s->state = S_REPLY_STATUS;
+	}
+	if (s->recvq)
+		set_active(s, READ);
+}
+#endif
+
+#if defined(__linux__) && defined(TCP_ZEROCOPY_RECEIVE)
+/*
+ * Have TCP_ZEROCOPY_RECEIVE map up to LEN bytes of the reply body into
+ * S's mapping of its socket instead of copying them.  Returns non-zero
+ * if that worked.  Otherwise, the data must be read(); the kernel only
+ * maps whole pages it received page-aligned, so *SKIP is set to the
+ * number of bytes after which mapping may work again (0 if unknown).
+ */
+static int
+recv_mapped(Conn * s, size_t len, size_t * skip)
+{
+	struct tcp_zerocopy_receive zc;
+	socklen_t       zc_len = sizeof(zc);
+	Call           *c = s->recvq;
+	char           *buf;
+	int             result;
+
+	*skip = 0;
+	if (!s->recv_map)
+		s->recv_map = mmap(0, param.bulk_recv, PROT_READ, MAP_SHARED,
+		    s->sd, 0);
+	if (s->recv_map == MAP_FAILED)
+		return 0;
+
+	if (len > param.bulk_recv)
+		len = param.bulk_recv;
+	memset(&zc, 0, sizeof(zc));
+	zc.address = (uintptr_t) s->recv_map;
+	zc.length = len & ~(page_size - 1);
+	SYSCALL(ZC_RECEIVE, result = getsockopt(s->sd, IPPROTO_TCP,
+		TCP_ZEROCOPY_RECEIVE, &zc, &zc_len));
+	++recv_calls;
+	if (result < 0) {
+		if (errno != EAGAIN) {
+			/*
+			 * not for this socket: stop trying 
+			 */
+			munmap(s->recv_map, param.bulk_recv);
+			s->recv_map = MAP_FAILED;
+		}
+		return 0;
+	}
+	if (zc.length == 0) {
+		*skip = zc.recv_skip_hint;
+		if (*skip > 0 && ++s->recv_map_misses >= RECV_MAP_MISSES) {
+			/*
+			 * data doesn't arrive page-aligned (e.g., over
+			 * loopback): stop paying for the attempts 
+			 */
+			munmap(s->recv_map, param.bulk_recv);
+			s->recv_map = MAP_FAILED;
+		}
+		return 0;
+	}
+	s->recv_map_misses = 0;
+	recv_bytes += zc.length;
+	recv_zc_bytes += zc.length;
+
+	buf = s->recv_map;
+	len = zc.length;
+	http_process_reply_bytes(c, &buf, &len);
+	if (s->state == S_REPLY_DONE) {
+		recv_done(c);
+		if (s->state >= S_CLOSING)
+			return 1;
+		s->state = S_REPLY_STATUS;
+	}
+	if (s->recvq)
+		set_active(s, READ);
+	return 1;
+}
+#endif
+
+static void
+do_recv(Conn * s)
+{
+	char            stack_buf[8193], *buf = stack_buf;
+	size_t          size = sizeof(stack_buf), len = 0;
+	ssize_t         nread = 0;
+
+#ifdef HAVE_ZEROCOPY
+	if (s->zerocopy_pending > 0)
+		zerocopy_reap(s);
+#endif
+#if defined(__linux__) && defined(MSG_TRUNC)
+	if (!SSL_USED() && (len = http_discardable_bytes(s->recvq)) > 0) {
+		do_discard(s, len);
+		return;
+	}
+#endif
+
+	if (param.bulk_recv > 0) {
+#if defined(__linux__) && defined(TCP_ZEROCOPY_RECEIVE)
+		if (!SSL_USED()
+		    && http_body_bytes(s->recvq) >= page_size
+		    && recv_mapped(s, http_body_bytes(s->recvq), &len))
+			return;
+#endif
+		if (!s->recv_buf && posix_memalign((void **) &s->recv_buf,
+		    page_size, param.bulk_recv) != 0) {
+			fprintf(stderr, "%s.do_recv: out of memory\n",
+			    prog_name);
+			exit(1);
+		}
+		buf = s->recv_buf;
+		size = param.bulk_recv;
+		if (len > 0 && len < size - 1)
+			size = len + 1;	/* up to where mapping works again */
+	}
+
+#ifdef HAVE_SSL
+	if (param.use_ssl && !s->ktls_recv) {
+		SYSCALL(SSL_READ,
+			nread = SSL_read(s->ssl, buf, size - 1));
+	} else
+#endif
+	{
+		SYSCALL(READ, nread = read(s->sd, buf, size - 1));
+#ifdef HAVE_SSL
+		/*
+		 * With kernel TLS, read() fails with EIO on records other
+		 * than application data (e.g., session tickets).  Let OpenSSL
+		 * consume those.
+		 */
+		if (nread < 0 && errno == EIO && s->ktls_recv) {
+			SYSCALL(SSL_READ,
+				nread = SSL_read(s->ssl, buf, size - 1));
+		} else
+#endif
+		if (nread > 0 && nread < (ssize_t) size - 1)
+			clear_ready(s, READ);	/* drained the socket */
+	}
+	recv_data(s, buf, nread, errno);
+}
+
 struct sockaddr_in *
 core_addr_intern(const char *server, size_t server_len, int port)
 {
@@ -795,19 +1693,21 @@ core_add_address(struct in_addr ip)
 {
 	struct local_addr *addr;
 
-	myaddrs.addresses = realloc(myaddrs.addresses,
-	    sizeof(struct local_addr) * (myaddrs.count + 1));
-	if (myaddrs.addresses == NULL) {
-		fprintf(stderr,
-			"%s: out of memory parsing address list\n",
-			prog_name);
-		exit(1);
+	if (myaddrs.count >= myaddrs.alloced) {
+		myaddrs.alloced = myaddrs.alloced ? 2 * myaddrs.alloced : 16;
+		myaddrs.addresses = realloc(myaddrs.addresses,
+		    sizeof(struct local_addr) * myaddrs.alloced);
+		if (myaddrs.addresses == NULL) {
+			fprintf(stderr,
+				"%s: out of memory parsing address list\n",
+				prog_name);
+			exit(1);
+		}
 	}
 	addr = &myaddrs.addresses[myaddrs.count];
+	memset(addr, 0, sizeof(*addr));
 	addr->ip = ip;
-	memset(&addr->port_free_map, 0xff, sizeof(addr->port_free_map));
-	addr->mask = ~0UL;
-	addr->previous = 0;
+	addr->next_port = MIN_IP_PORT;
 	myaddrs.count++;
 }
 
@@ -861,9 +1761,14 @@ core_add_addresses(const char *spec)
 			exit(1);
 		}
 
+		if (ntohl(ip.s_addr) > ntohl(end_ip.s_addr)) {
+			fprintf(stderr, "%s: invalid address range %s\n",
+			    prog_name, spec);
+			exit(1);
+		}
 		while (ip.s_addr != end_ip.s_addr) {
 			core_add_address(ip);
-			ip.s_addr += htonl(1);
+			ip.s_addr = htonl(ntohl(ip.s_addr) + 1);
 		}
 		core_add_address(end_ip);
 		return;
@@ -929,6 +1834,168 @@ core_runtime_timer(struct Timer *t, Any_Type arg)
 	core_exit();
 }
 
+/*
+ * The socket options every connection gets.  Linux has no way to apply
+ * options to all future sockets, so they are still set one by one; but
+ * the list is worked out and tried on a scratch socket only once, so
+ * that options the kernel lacks are dropped (with a warning) up front
+ * instead of failing each connection.
+ */
+struct sock_opt {
+	int             level, name;
+	const char     *label;
+	union {
+		int             i;
+		struct linger   l;
+	}               val;
+	socklen_t       len;
+};
+
+static struct sock_opt sock_profile[8];
+static int      sock_profile_len;
+static int      sock_type = SOCK_STREAM;
+static int      port_kernel;	/* kernel picks --hog ports at connect() */
+
+/*
+ * Try option NAME on the scratch socket SD and add it to the profile if
+ * that works.  If it doesn't, an OPTIONAL option is left out; otherwise
+ * it's a fatal error.  Returns non-zero if the option was added.
+ */
+static int
+sock_profile_add(int sd, int level, int name, const char *label,
+		 const void *val, socklen_t len, int optional)
+{
+	struct sock_opt *o = &sock_profile[sock_profile_len];
+
+	assert(sock_profile_len < NELEMS(sock_profile));
+	if (setsockopt(sd, level, name, val, len) < 0) {
+		fprintf(stderr, "%s: %s setsockopt(%s): %s\n", prog_name,
+			optional ? "warning: ignoring" : "failed to",
+			label, strerror(errno));
+		if (!optional)
+			exit(1);
+		return 0;
+	}
+	o->level = level;
+	o->name = name;
+	o->label = label;
+	memcpy(&o->val, val, len);
+	o->len = len;
+	++sock_profile_len;
+	return 1;
+}
+
+static void
+sock_profile_init(void)
+{
+	struct linger   linger;
+	int             sd, optval;
+
+#ifdef SOCK_NONBLOCK
+	/*
+	 * Saves an fcntl() per connection.  The ring waits for plain
+	 * sockets itself; only SSL, which reads and writes on its own,
+	 * needs them non-blocking.
+	 */
+# ifdef HAVE_IO_URING
+	if (SSL_USED())
+# endif
+		sock_type |= SOCK_NONBLOCK;
+#endif
+
+	sd = socket(AF_INET, SOCK_STREAM, 0);
+	if (sd < 0) {
+		fprintf(stderr, "%s: failed to create a socket: %s\n",
+			prog_name, strerror(errno));
+		exit(1);
+	}
+
+	if (param.close_with_reset) {
+		linger.l_onoff = 1;
+		linger.l_linger = 0;
+		sock_profile_add(sd, SOL_SOCKET, SO_LINGER, "SO_LINGER",
+				 &linger, sizeof(linger), 0);
+	}
+
+	/*
+	 * Disable Nagle algorithm so we don't delay needlessly when
+	 * pipelining requests.  
+	 */
+	optval = 1;
+	sock_profile_add(sd, SOL_TCP, TCP_NODELAY, "TCP_NODELAY",
+			 &optval, sizeof(optval), 0);
+
+	/*
+	 * A size of 0 leaves the buffer to the kernel (and its
+	 * autotuning).
+	 */
+	if (param.send_buffer_size > 0) {
+		optval = param.send_buffer_size;
+		sock_profile_add(sd, SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF",
+				 &optval, sizeof(optval), 0);
+	}
+	if (param.recv_buffer_size > 0) {
+		optval = param.recv_buffer_size;
+		sock_profile_add(sd, SOL_SOCKET, SO_RCVBUF, "SO_RCVBUF",
+				 &optval, sizeof(optval), 0);
+	}
+
+#ifdef HAVE_ZEROCOPY
+	/*
+	 * Kernels without SO_ZEROCOPY just keep copying.
+	 */
+	optval = 1;
+	if (param.zerocopy > 0
+	    && !sock_profile_add(sd, SOL_SOCKET, SO_ZEROCOPY, "SO_ZEROCOPY",
+				 &optval, sizeof(optval), 1))
+		param.zerocopy = 0;
+#endif
+
+	if (param.tfo) {
+#ifdef TCP_FASTOPEN_CONNECT
+		/*
+		 * connect() returns right away and the SYN goes out with
+		 * the first request (if the server gave us a cookie
+		 * before).
+		 */
+		optval = 1;
+		if (!sock_profile_add(sd, SOL_TCP, TCP_FASTOPEN_CONNECT,
+				      "TCP_FASTOPEN_CONNECT", &optval,
+				      sizeof(optval), 1))
+			param.tfo = 0;
+#else
+		fprintf(stderr, "%s: warning: TCP Fast Open is not supported "
+			"on this system\n", prog_name);
+		param.tfo = 0;
+#endif
+	}
+
+#ifdef IP_BIND_ADDRESS_NO_PORT
+	/*
+	 * Binding a source address normally reserves a port right away,
+	 * so each port can be used for one connection only.  Leaving the
+	 * choice to connect() lets the kernel share ports across servers
+	 * and, with the port range widened to what --hog wants, saves us
+	 * tracking ports at all.
+	 */
+	if (param.hog || myaddrs.count > 1
+	    || myaddrs.addresses[0].ip.s_addr != htonl(INADDR_ANY)) {
+		optval = 1;
+		if (sock_profile_add(sd, SOL_IP, IP_BIND_ADDRESS_NO_PORT,
+				     "IP_BIND_ADDRESS_NO_PORT", &optval,
+				     sizeof(optval), 1) && param.hog) {
+# ifdef IP_LOCAL_PORT_RANGE
+			optval = (MAX_IP_PORT << 16) | MIN_IP_PORT;
+			port_kernel = sock_profile_add(sd, SOL_IP,
+			    IP_LOCAL_PORT_RANGE, "IP_LOCAL_PORT_RANGE",
+			    &optval, sizeof(optval), 1);
+# endif
+		}
+	}
+#endif
+	close(sd);
+}
+
 void
 core_init(void)
 {
@@ -936,7 +2003,8 @@ core_init(void)
 	Any_Type        arg;
 
 	memset(&hash_table, 0, sizeof(hash_table));
-#if !defined(HAVE_KEVENT) && !defined(HAVE_EPOLL)
+	page_size = sysconf(_SC_PAGESIZE);
+#if !defined(HAVE_KEVENT) && !defined(HAVE_EPOLL) && !defined(HAVE_IO_URING)
 	memset(&rdfds, 0, sizeof(rdfds));
 	memset(&wrfds, 0, sizeof(wrfds));
 #endif
@@ -950,6 +2018,8 @@ core_init(void)
 	if (myaddrs.count == 0)
 		core_add_address(myaddr.sin_addr);
 
+	sock_profile_init();
+
 	/*
 	 * Don't disturb just because a TCP connection closed on us... 
 	 */
@@ -991,24 +2061,9 @@ core_init(void)
 		    strerror(errno));
 		exit(1);
 	}
-	epoll_timeout = 0;
 #else
-#ifdef DONT_POLL
-	/*
-	 * This causes select() to take several milliseconds on both Linux/x86 
-	 * and HP-UX 10.20.  
-	 */
-	select_timeout.tv_sec = (u_long) TIMER_INTERVAL;
-	select_timeout.tv_usec = (u_long) (TIMER_INTERVAL * 1e6);
-#else
-	/*
-	 * This causes httperf to become a CPU hog as it polls for
-	 * filedescriptors to become readable/writable.  This is OK as long as 
-	 * httperf is the only (interesting) user-level process that executes
-	 * on a machine.  
-	 */
-	select_timeout.tv_sec = 0;
-	select_timeout.tv_usec = 0;
+#ifdef HAVE_IO_URING
+	ring_init();
 #endif
 #endif
 #endif
@@ -1040,80 +2095,312 @@ core_init(void)
 	else if (param.server)
 		core_addr_intern(param.server, strlen(param.server), param.port);
 
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+	if (param.use_ssl && param.ssl_threads > 0)
+		ssl_pool_start();
+#endif
+
 	if (param.runtime) {
 		arg.l = 0;
 		timer_schedule(core_runtime_timer, arg, param.runtime);
 	}
 }
 
+/*
+ * Close CONN's socket SD and forget about it in the event backend.
+ */
+static void
+close_sd(Conn * conn, int sd)
+{
+#ifdef HAVE_EPOLL
+	/* close() drops the registration; no EPOLL_CTL_DEL needed */
+	conn->epoll_added = 0;
+	conn->epoll_mask = 0;
+	conn->epoll_ready = 0;
+#endif
+#ifdef HAVE_IO_URING
+	ring_close(conn, sd);
+#else
+	close(sd);
+#endif
+#if !defined(HAVE_KEVENT) && !defined(HAVE_EPOLL) && !defined(HAVE_IO_URING)
+	sd_to_conn[sd] = 0;
+	FD_CLR(sd, &wrfds);
+	FD_CLR(sd, &rdfds);
+#endif
+	conn->reading = 0;
+	conn->writing = 0;
+}
+
 #ifdef HAVE_SSL
 
-void
-core_ssl_connect(Conn * s)
+#define SSL_STEP_EARLY	0x100	/* early data went out during the step */
+
+/*
+ * Run S's handshake as far as it goes without blocking.  Returns
+ * SSL_ERROR_NONE once the handshake is complete and the SSL_get_error()
+ * reason otherwise, or'ed with SSL_STEP_EARLY if the early data got
+ * written.  With --ssl-threads this runs on a worker, so it must touch
+ * nothing but the SSL object.
+ */
+static int
+ssl_handshake_step(Conn * s)
 {
-	Any_Type        arg;
-	int             ssl_err;
+	int             ret, step = 0;
+
+	ERR_clear_error();
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	if (s->ssl_early_pending) {
+		Req_Template   *t = s->ssl_early_call->req.tmpl;
+		size_t          written;
+
+		ret = SSL_write_early_data(s->ssl, t->data, t->len, &written);
+		if (ret <= 0)
+			return SSL_get_error(s->ssl, ret);
+		step = SSL_STEP_EARLY;
+	}
+#endif
+	ret = SSL_connect(s->ssl);
+	if (ret < 0) {
+		ret = SSL_get_error(s->ssl, ret);
+		if (ret != SSL_ERROR_WANT_READ && ret != SSL_ERROR_WANT_WRITE)
+			ERR_print_errors_fp(stderr);
+		return step | ret;
+	}
+	return step;
+}
 
-	if (DBG > 2)
-		fprintf(stderr, "core_ssl_connect(conn=%p)\n", (void *) s);
+/*
+ * Called just before S's handshake starts: offer a cached session and
+ * decide whether the first request can go out as early data.
+ */
+static void
+ssl_handshake_start(Conn * s)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	Call           *call;
+#endif
 
-	if (SSL_set_fd(s->ssl, s->sd) == 0) {
-		ERR_print_errors_fp(stderr);
+	s->ssl_handshake_start = timer_now();
+	if (param.ssl_resume.cache_size > 0)
+		ssl_cache_offer(s);
+	s->ssl_offered = SSL_get_session(s->ssl) != 0;
+
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	call = s->sendq;
+	if (param.ssl_early_data && s->ssl_offered && call && call->req.tmpl
+	    && call->req.tmpl_sent == 0 && call->req.tmpl->len
+	    <= SSL_SESSION_get_max_early_data(SSL_get_session(s->ssl))) {
+		s->ssl_early_pending = 1;
+		s->ssl_early_call = call;
+		call_inc_ref(call);	/* a close must not free the data */
+	}
+#endif
+}
+
+/*
+ * Act on the outcome RESULT of a handshake step: wait for the socket,
+ * give up, or declare S connected.
+ */
+static void
+ssl_handshake_done(Conn * s, int result)
+{
+	int             reason = result & ~SSL_STEP_EARLY;
+
+	if (result & SSL_STEP_EARLY) {
+		s->ssl_early_pending = 0;
+		s->ssl_early_sent = 1;
+	}
+
+	if (reason == SSL_ERROR_WANT_READ || reason == SSL_ERROR_WANT_WRITE) {
+		if (DBG > 2)
+			fprintf(stderr,
+				"core_ssl_connect: want to %s more...\n",
+				(reason ==
+				 SSL_ERROR_WANT_READ) ? "read" : "write");
+		/*
+		 * A worker's view of the socket is stale by now: readiness
+		 * that arrived meanwhile must not be forgotten.
+		 */
+		if (!param.ssl_threads)
+			clear_ready(s, reason == SSL_ERROR_WANT_READ ?
+			    READ : WRITE);
+		if (reason == SSL_ERROR_WANT_READ && !s->reading) {
+			clear_active(s, WRITE);
+			set_active(s, READ);
+		} else if (reason == SSL_ERROR_WANT_WRITE && !s->writing) {
+			clear_active(s, READ);
+			set_active(s, WRITE);
+		}
+		return;
+	}
+	if (reason != SSL_ERROR_NONE) {
+		fprintf(stderr,
+			"%s: failed to connect to SSL server (reason=%d)\n",
+			prog_name, reason);
 		exit(-1);
 	}
 
-	ssl_err = SSL_connect(s->ssl);
-	if (ssl_err < 0) {
-		int             reason = SSL_get_error(s->ssl, ssl_err);
+	s->state = S_CONNECTED;
+
+	if (DBG > 0)
+		fprintf(stderr, "core_ssl_connect: SSL is connected!\n");
+
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+	if (param.ssl_ktls) {
+		static int      warned;
+
+		s->ktls_send = BIO_get_ktls_send(SSL_get_wbio(s->ssl));
+		s->ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(s->ssl));
+		if (DBG > 1)
+			fprintf(stderr, "core_ssl_connect: ktls send=%d recv=%d\n",
+			    s->ktls_send, s->ktls_recv);
+		if (!s->ktls_send && !s->ktls_recv && !warned) {
+			fprintf(stderr, "%s: kernel TLS unavailable for this "
+			    "cipher or kernel (is the tls module loaded?)\n",
+			    prog_name);
+			warned = 1;
+		}
+	}
+#endif
+
+	if (DBG > 1) {
+		const SSL_CIPHER     *ssl_cipher;
+
+		ssl_cipher = SSL_get_current_cipher(s->ssl);
+		if (!ssl_cipher)
+			fprintf(stderr,
+				"core_ssl_connect: server refused all client cipher "
+				"suites!\n");
+		else
+			fprintf(stderr,
+				"core_ssl_connect: cipher=%s, id=%lu\n",
+				SSL_CIPHER_get_name(ssl_cipher),
+				SSL_CIPHER_get_id(ssl_cipher));
+	}
+
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	/*
+	 * Accepted early data completes the first request; rejected early
+	 * data has to be sent again like any other request.
+	 */
+	if (s->ssl_early_sent
+	    && SSL_get_early_data_status(s->ssl) == SSL_EARLY_DATA_ACCEPTED)
+		send_progress(s, s->sendq, s->sendq->req.tmpl->len);
+#endif
+	if (s->ssl_early_call) {
+		call_dec_ref(s->ssl_early_call);
+		s->ssl_early_call = 0;
+	}
+	if (s->sendq)
+		set_active(s, WRITE);	/* queued while handshaking */
+
+	conn_signal(s, EV_CONN_CONNECTED, 0);
+}
+
+#ifdef HAVE_PTHREAD
+/*
+ * Pick up the handshake steps that the workers have finished.
+ */
+static void
+ssl_pool_complete(void)
+{
+	Conn           *s, *next;
+
+	for (s = ssl_pool_collect(); s; s = next) {
+		next = s->ssl_job_next;
+		s->ssl_busy = 0;
+		if (s->state < S_CLOSING)
+			ssl_handshake_done(s, s->ssl_job_result);
+		else if (s->ssl_busy_sd >= 0) {
+			/* core_close() left the socket to us */
+			close_sd(s, s->ssl_busy_sd);
+			s->ssl_busy_sd = -1;
+		}
+		conn_dec_ref(s);
+	}
+}
+
+/*
+ * Start the handshake workers and have the event loop watch for the
+ * steps they finish.
+ */
+static void
+ssl_pool_start(void)
+{
+#ifdef HAVE_KEVENT
+	struct kevent	ev;
+#endif
+#ifdef HAVE_EPOLL
+	struct epoll_event ev;
+#endif
+
+	ssl_wake_fd = ssl_pool_init(param.ssl_threads, ssl_handshake_step);
+#ifdef HAVE_KEVENT
+	EV_SET(&ev, ssl_wake_fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	if (kevent(kq, &ev, 1, NULL, 0, NULL) < 0) {
+		fprintf(stderr, "failed to add read filter\n");
+		exit(1);
+	}
+#else
+#ifdef HAVE_EPOLL
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ssl_wake_fd, &ev) < 0) {
+		fprintf(stderr, "%s.ssl_pool_start: epoll_ctl failed: %s\n",
+		    prog_name, strerror(errno));
+		exit(1);
+	}
+#else
+#ifdef HAVE_IO_URING
+	ring_poll_wake();
+#else
+	FD_SET(ssl_wake_fd, &rdfds);
+	if (ssl_wake_fd < min_sd)
+		min_sd = ssl_wake_fd;
+#endif
+#endif
+#endif
+	if (ssl_wake_fd > max_sd)
+		max_sd = ssl_wake_fd;
+}
+#endif
+
+void
+core_ssl_connect(Conn * s)
+{
+	if (DBG > 2)
+		fprintf(stderr, "core_ssl_connect(conn=%p)\n", (void *) s);
+
+	if (s->ssl_busy)
+		return;		/* a worker is on it */
 
-		if (reason == SSL_ERROR_WANT_READ
-		    || reason == SSL_ERROR_WANT_WRITE) {
-			if (DBG > 2)
-				fprintf(stderr,
-					"core_ssl_connect: want to %s more...\n",
-					(reason ==
-					 SSL_ERROR_WANT_READ) ? "read" :
-					"write");
-			if (reason == SSL_ERROR_WANT_READ
-			    && !s->reading) {
-				clear_active(s, WRITE);
-				set_active(s, READ);
-			} else if (reason == SSL_ERROR_WANT_WRITE
-				   && !s->writing) {
-				clear_active(s, READ);
-				set_active(s, WRITE);
-			}
-			return;
-		}
-		fprintf(stderr,
-			"%s: failed to connect to SSL server (err=%d, reason=%d)\n",
-			prog_name, ssl_err, reason);
+	if (SSL_set_fd(s->ssl, s->sd) == 0) {
 		ERR_print_errors_fp(stderr);
 		exit(-1);
 	}
 
-	s->state = S_CONNECTED;
-
-	if (DBG > 0)
-		fprintf(stderr, "core_ssl_connect: SSL is connected!\n");
+	if (SSL_in_before(s->ssl))
+		ssl_handshake_start(s);
 
-	if (DBG > 1) {
-		const SSL_CIPHER     *ssl_cipher;
-
-		ssl_cipher = SSL_get_current_cipher(s->ssl);
-		if (!ssl_cipher)
-			fprintf(stderr,
-				"core_ssl_connect: server refused all client cipher "
-				"suites!\n");
-		else
-			fprintf(stderr,
-				"core_ssl_connect: cipher=%s, id=%lu\n",
-				SSL_CIPHER_get_name(ssl_cipher),
-				SSL_CIPHER_get_id(ssl_cipher));
+#ifdef HAVE_PTHREAD
+	if (param.ssl_threads > 0) {
+		/*
+		 * Stop watching the socket while a worker drives the
+		 * handshake; ssl_handshake_done() resumes when it is back.
+		 */
+		if (s->reading)
+			clear_active(s, READ);
+		if (s->writing)
+			clear_active(s, WRITE);
+		s->ssl_busy = 1;
+		s->ssl_busy_sd = -1;
+		conn_inc_ref(s);
+		ssl_pool_submit(s);
+		return;
 	}
-
-	arg.l = 0;
-	event_signal(EV_CONN_CONNECTED, (Object *) s, arg);
+#endif
+	ssl_handshake_done(s, ssl_handshake_step(s));
 }
 
 #endif /* HAVE_SSL */
@@ -1124,12 +2411,23 @@ core_connect(Conn * s)
 	int             sd, result, async_errno;
 	socklen_t       len;
 	struct sockaddr_in *sin;
-	struct linger   linger;
-	int             myport, optval;
+	struct sock_opt *o;
+	int             myport;
 	Any_Type        arg;
 	static int      prev_iteration = -1;
 	static u_long   burst_len;
 
+	if (s->warm) {
+		/*
+		 * Set up by the warm-up phase; to the generator it looks
+		 * like a connection that was established right away.
+		 */
+		conn_signal(s, EV_CONN_CONNECTING, 0);
+		if (s->state == S_CONNECTED)
+			conn_signal(s, EV_CONN_CONNECTED, 0);
+		return 0;
+	}
+
 	if (iteration == prev_iteration)
 		++burst_len;
 	else {
@@ -1139,7 +2437,7 @@ core_connect(Conn * s)
 		prev_iteration = iteration;
 	}
 
-	SYSCALL(SOCKET, sd = socket(AF_INET, SOCK_STREAM, 0));
+	SYSCALL(SOCKET, sd = socket(AF_INET, sock_type, 0));
 	if (sd < 0) {
 		if (DBG > 0)
 			fprintf(stderr,
@@ -1148,51 +2446,32 @@ core_connect(Conn * s)
 		goto failure;
 	}
 
+#ifndef SOCK_NONBLOCK
+#ifdef HAVE_IO_URING
+	if (SSL_USED())
+#endif
 	if (fcntl(sd, F_SETFL, O_NONBLOCK) < 0) {
 		fprintf(stderr, "%s.core_connect.fcntl: %s\n",
 			prog_name, strerror(errno));
 		goto failure;
 	}
+#endif
 
-	if (param.close_with_reset) {
-		linger.l_onoff = 1;
-		linger.l_linger = 0;
-		if (setsockopt
-		    (sd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger)) < 0) {
+	for (o = sock_profile; o < sock_profile + sock_profile_len; ++o)
+		if (setsockopt(sd, o->level, o->name, &o->val, o->len) < 0) {
 			fprintf(stderr,
-				"%s.core_connect.setsockopt(SO_LINGER): %s\n",
-				prog_name, strerror(errno));
+				"%s.core_connect.setsockopt(%s): %s\n",
+				prog_name, o->label, strerror(errno));
 			goto failure;
 		}
-	}
-
-	/*
-	 * Disable Nagle algorithm so we don't delay needlessly when
-	 * pipelining requests.  
-	 */
-	optval = 1;
-	if (setsockopt(sd, SOL_TCP, TCP_NODELAY, &optval, sizeof(optval)) < 0) {
-		fprintf(stderr, "%s.core_connect.setsockopt(SO_SNDBUF): %s\n",
-			prog_name, strerror(errno));
-		goto failure;
-	}
-
-	optval = param.send_buffer_size;
-	if (setsockopt(sd, SOL_SOCKET, SO_SNDBUF, &optval, sizeof(optval)) < 0) {
-		fprintf(stderr, "%s.core_connect.setsockopt(SO_SNDBUF): %s\n",
-			prog_name, strerror(errno));
-		goto failure;
-	}
-
-	optval = param.recv_buffer_size;
-	if (setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &optval, sizeof(optval)) < 0) {
-		fprintf(stderr, "%s.core_connect.setsockopt(SO_SNDBUF): %s\n",
-			prog_name, strerror(errno));
-		goto failure;
-	}
+#ifdef HAVE_ZEROCOPY
+	s->zerocopy = param.zerocopy > 0;
+	s->zerocopy_pending = 0;
+#endif
+	s->tfo = param.tfo;
 
 	s->sd = sd;
-#if !defined(HAVE_KEVENT) && !defined(HAVE_EPOLL)
+#if !defined(HAVE_KEVENT) && !defined(HAVE_EPOLL) && !defined(HAVE_IO_URING)
 	if (sd >= alloced_sd_to_conn) {
 		size_t          size, old_size;
 
@@ -1225,14 +2504,13 @@ core_connect(Conn * s)
 		goto failure;
 	}
 
-	arg.l = 0;
-	event_signal(EV_CONN_CONNECTING, (Object *) s, arg);
+	conn_signal(s, EV_CONN_CONNECTING, 0);
 	if (s->state >= S_CLOSING)
 		goto failure;
 
 	s->myaddr = core_get_next_myaddr();
 	myaddr.sin_addr = s->myaddr->ip;
-	if (param.hog) {
+	if (param.hog && !port_kernel) {
 		while (1) {
 			myport = port_get(s->myaddr);
 			if (myport < 0)
@@ -1262,19 +2540,30 @@ core_connect(Conn * s)
 			goto failure;
 	}
 
+#ifdef HAVE_IO_URING
+	ring_connect(s, sin);
+	result = -1;
+	errno = EINPROGRESS;
+#else
 	SYSCALL(CONNECT,
 		result = connect(sd, (struct sockaddr *) sin, sizeof(*sin)));
-	if (result == 0) {
+#endif
+	if (s->tfo && (result == 0 || errno == EINPROGRESS))
+		++tfo_tried;
 #ifdef HAVE_SSL
-		if (param.use_ssl)
-			core_ssl_connect(s);
-		else
+	/*
+	 * With TCP_FASTOPEN_CONNECT, connect() succeeds before the SYN is
+	 * sent.  Let the handshake start from the event loop like any
+	 * other pending connection so that it is watched and timed.
+	 */
+	if (result == 0 && param.use_ssl) {
+		result = -1;
+		errno = EINPROGRESS;
+	}
 #endif
-		{
-			s->state = S_CONNECTED;
-			arg.l = 0;
-			event_signal(EV_CONN_CONNECTED, (Object *) s, arg);
-		}
+	if (result == 0) {
+		s->state = S_CONNECTED;
+		conn_signal(s, EV_CONN_CONNECTED, 0);
 	} else if (errno == EINPROGRESS) {
 		/*
 		 * The socket becomes writable only after the connection has
@@ -1371,6 +2660,7 @@ core_send(Conn * conn, Call * call)
 	}
 	call->req.iov_index = 0;
 	call->req.iov_saved = call->req.iov[0];
+	call_serialize_request(call);
 
 	/*
 	 * insert call into connection's send queue: 
@@ -1385,7 +2675,8 @@ core_send(Conn * conn, Call * call)
 			return -1;
 		call->timeout =
 		    param.timeout ? timer_now() + param.timeout : 0.0;
-		set_active(conn, WRITE);
+		if (conn->state != S_INITIAL)	/* else core_connect() will */
+			set_active(conn, WRITE);
 	} else {
 		conn->sendq_tail->sendq_next = call;
 		conn->sendq_tail = call;
@@ -1397,8 +2688,11 @@ void
 core_close(Conn * conn)
 {
 	Call           *call, *call_next;
-	Any_Type        arg;
 	int             sd;
+#ifdef TCPI_OPT_SYN_DATA
+	struct tcp_info info;
+	socklen_t       len;
+#endif
 
 	if (conn->state >= S_CLOSING)
 		return;		/* guard against recursive calls */
@@ -1430,38 +2724,32 @@ core_close(Conn * conn)
 	sd = conn->sd;
 	conn->sd = -1;
 
-	arg.l = 0;
-	event_signal(EV_CONN_CLOSE, (Object *) conn, arg);
+#ifdef TCPI_OPT_SYN_DATA
+	if (conn->tfo && sd >= 0) {
+		len = sizeof(info);
+		if (getsockopt(sd, SOL_TCP, TCP_INFO, &info, &len) == 0
+		    && (info.tcpi_options & TCPI_OPT_SYN_DATA))
+			++tfo_used;
+	}
+#endif
+
+	conn_signal(conn, EV_CONN_CLOSE, 0);
 	assert(conn->state == S_CLOSING);
 
 #ifdef HAVE_SSL
-	if (param.use_ssl)
+	if (conn->ssl_busy) {
+		/*
+		 * A handshake worker still uses the socket, so it gets closed
+		 * only once the worker is done (see ssl_pool_complete()).
+		 */
+		conn->ssl_busy_sd = sd;
+		sd = -1;
+	} else if (param.use_ssl)
 		SSL_shutdown(conn->ssl);
 #endif
 
-	if (sd >= 0) {
-#ifdef HAVE_EPOLL
-		struct epoll_event ev = { 0, { 0 } };
-		int error;
-
-		error = epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sd, &ev);
-		if (error < 0) {
-			if (conn->epoll_added == 1 && error != ENOENT) {
-				error = errno;
-				printf("EPOLL_CTL_DEL: %d %d %d\n", epoll_fd, sd, error);
-				assert(error == 0);
-			}
-		}
-#endif
-		close(sd);
-#if !defined(HAVE_KEVENT) && !defined(HAVE_EPOLL)
-		sd_to_conn[sd] = 0;
-		FD_CLR(sd, &wrfds);
-		FD_CLR(sd, &rdfds);
-#endif
-		conn->reading = 0;
-		conn->writing = 0;
-	}
+	if (sd >= 0)
+		close_sd(conn, sd);
 	if (conn->myport > 0)
 		port_put(conn->myaddr, conn->myport);
 
@@ -1473,13 +2761,30 @@ core_close(Conn * conn)
 	conn_dec_ref(conn);
 }
 
+#ifndef HAVE_KEVENT
+/*
+ * Returns how long the event loop may block waiting for I/O: until the
+ * next timer is due, or not at all when that is within the busy-poll
+ * window.  Negative means until there is I/O.
+ */
+static Time
+core_wait_timeout(void)
+{
+	Time            timeout;
+
+	timeout = timer_next_timeout();
+	if (timeout >= 0 && timeout <= param.busy_poll)
+		return 0;
+	return timeout;
+}
+#endif
+
 #ifdef HAVE_KEVENT
 void
 core_loop(void)
 {
 	struct kevent ev;
 	int n;
-	Any_Type   arg;
 	Conn      *conn;
 
 	while (running) {
@@ -1499,6 +2804,12 @@ core_loop(void)
 		case EVFILT_READ:
 		case EVFILT_WRITE:
 			conn = ev.udata;
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+			if (!conn) {
+				ssl_pool_complete();
+				break;
+			}
+#endif
 	                conn_inc_ref(conn);
 
 	                if (conn->watchdog) {
@@ -1514,8 +2825,7 @@ core_loop(void)
 	                    if (ev.filter == EVFILT_WRITE) {
 				clear_active(conn, WRITE);
 	                        conn->state = S_CONNECTED;
-	                        arg.l = 0;
-	                        event_signal(EV_CONN_CONNECTED, (Object*)conn, arg);
+	                        conn_signal(conn, EV_CONN_CONNECTED, 0);
 	                    }
 	                } else {
 			    if (ev.filter == EVFILT_WRITE && conn->sendq)
@@ -1531,55 +2841,281 @@ core_loop(void)
 }
 #else
 #ifdef HAVE_EPOLL
+/*
+ * Waits for events for at most TIMEOUT seconds (forever if negative).
+ */
+static int
+epoll_wait_timeout(Time timeout)
+{
+#ifdef HAVE_EPOLL_PWAIT2
+	static int      have_pwait2 = 1;
+	struct timespec ts;
+	int             n;
+
+	if (have_pwait2) {
+		ts.tv_sec = (time_t) timeout;
+		ts.tv_nsec = (long) ((timeout - ts.tv_sec) * 1e9);
+		n = epoll_pwait2(epoll_fd, epoll_events, EPOLL_N_MAX,
+		    timeout < 0 ? NULL : &ts, NULL);
+		if (n >= 0 || errno != ENOSYS)
+			return n;
+		have_pwait2 = 0;
+	}
+#endif
+	/*
+	 * Round up to whole milliseconds so as not to wake up before the
+	 * timer is due. 
+	 */
+	return epoll_wait(epoll_fd, epoll_events, EPOLL_N_MAX,
+	    timeout < 0 ? -1 : (int) (timeout * 1e3 + 0.999));
+}
+
+/*
+ * Handles S being READABLE and/or WRITABLE.
+ */
+static void
+epoll_dispatch(Conn * s, int readable, int writable)
+{
+
+	if (s->state == S_CONNECTING) {
+		if (!(readable && s->reading) && !(writable && s->writing))
+			return;
+	} else if (!(readable && s->recvq) && !(writable && s->sendq))
+		return;		/* an edge nobody is waiting for */
+
+	conn_inc_ref(s);
+
+	if (s->watchdog) {
+		timer_cancel(s->watchdog);
+		s->watchdog = 0;
+	}
+	if (s->state == S_CONNECTING) {
+#ifdef HAVE_SSL
+		if (param.use_ssl)
+			core_ssl_connect(s);
+		else
+#endif
+		if (writable) {
+			clear_active(s, WRITE);
+			s->state = S_CONNECTED;
+			conn_signal(s, EV_CONN_CONNECTED, 0);
+		}
+	} else {
+		if (readable && s->recvq)
+			do_recv(s);
+		if (writable && s->sendq)
+			do_send(s);
+	}
+	conn_dec_ref(s);
+}
+
+/*
+ * Works off the connections queued so far.  Level-triggered, that means
+ * bringing their registration in line with what they are waiting for.
+ * Edge-triggered, it means doing the work for which the edge has
+ * already been consumed.  Connections queued meanwhile wait for the
+ * next call.
+ */
+static void
+epoll_flush(void)
+{
+	Conn           *s, *next;
+	u_int           events;
+
+	s = epoll_list;
+	epoll_list = epoll_list_tail = 0;
+	for (; s; s = next) {
+		next = s->epoll_next;
+		s->epoll_queued = 0;
+		if (s->sd >= 0 && s->state < S_CLOSING) {
+			if (param.edge_triggered)
+				epoll_dispatch(s, s->epoll_ready & (1 << READ),
+				    s->epoll_ready & (1 << WRITE));
+			else {
+				events = 0;
+				if (s->reading)
+					events |= EPOLLIN;
+				if (s->writing)
+					events |= EPOLLOUT;
+				epoll_register(s, events);
+			}
+		}
+		conn_dec_ref(s);
+	}
+}
+
 void
 core_loop(void)
 {
 	struct epoll_event *ep;
-	int i, n;
-	Any_Type   arg;
+	int i, n, readable, writable;
 	Conn      *conn;
+	Time       timeout;
 
 	while (running) {
 		++iteration;
 
 		timer_tick();
-		n = epoll_wait(epoll_fd, epoll_events, EPOLL_N_MAX, epoll_timeout);
-		if (n < 0 && errno == EINTR) {
-			fprintf(stderr, "failed to fetch event: %s",
-			    strerror(errno));
-			continue;
+		epoll_flush();
+		timeout = epoll_list ? 0 : core_wait_timeout();
+		n = epoll_wait_timeout(timeout);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "%s.core_loop: epoll_wait failed: %s\n",
+			    prog_name, strerror(errno));
+			exit(1);
 		}
+		if (timeout != 0)
+			timer_refresh();
 		ep = epoll_events;
 		for (i = 0; i < n; i++, ep++) {
 			conn = ep->data.ptr;
-			conn_inc_ref(conn);
-
-			if (conn->watchdog) {
-				timer_cancel(conn->watchdog);
-				conn->watchdog = 0;
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+			if (!conn) {
+				ssl_pool_complete();
+				continue;
 			}
-			if (conn->state == S_CONNECTING) {
-#ifdef HAVE_SSL
-				if (param.use_ssl)
-					core_ssl_connect(conn);
-				else
-#endif
-				if (ep->events & EPOLLOUT) {
-					clear_active(conn, WRITE);
-					conn->state = S_CONNECTED;
-					arg.l = 0;
-					event_signal(EV_CONN_CONNECTED, (Object*)conn, arg);
-				}
-			} else {
-				if (ep->events & (EPOLLIN | EPOLLHUP) && conn->recvq)
-					do_recv(conn);
-				if (ep->events & EPOLLOUT && conn->sendq)
-					do_send(conn);
+#endif
+#ifdef HAVE_ZEROCOPY
+			/*
+			 * Completed MSG_ZEROCOPY sends also show up as
+			 * errors; collect them even if the connection isn't
+			 * waiting for anything right now.
+			 */
+			if ((ep->events & EPOLLERR) && conn->zerocopy_pending)
+				zerocopy_reap(conn);
+#endif
+			readable = (ep->events
+			    & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+			writable = (ep->events
+			    & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0;
+			if (param.edge_triggered) {
+				/*
+				 * Remember readiness until the socket runs
+				 * dry: the edge will not be reported again.
+				 */
+				if (readable)
+					conn->epoll_ready |= 1 << READ;
+				if (writable)
+					conn->epoll_ready |= 1 << WRITE;
 			}
-			conn_dec_ref(conn);
+			epoll_dispatch(conn, readable, writable);
+		}
+	}
+}
+#else
+#ifdef HAVE_IO_URING
+static void
+ring_complete(Conn * conn, enum IO_DIR dir, int res)
+{
+	Call           *call = 0;
+	char           *buf = 0;
+
+	if (dir == WRITE) {
+		conn->writing = 0;
+		call = conn->ring_call;
+		conn->ring_call = 0;
+	} else {
+		conn->reading = 0;
+		buf = conn->ring_buf;
+		conn->ring_buf = 0;
+	}
+
+	if (conn->state >= S_CLOSING)
+		goto done;	/* cancelled or raced with close */
+
+	if (conn->watchdog) {
+		timer_cancel(conn->watchdog);
+		conn->watchdog = 0;
+	}
+	if (conn->state == S_CONNECTING) {
+		if (res < 0)
+			conn_failure(conn, -res);
+#ifdef HAVE_SSL
+		else if (param.use_ssl)
+			core_ssl_connect(conn);
+#endif
+		else if (dir == WRITE) {
+			conn->state = S_CONNECTED;
+			conn_signal(conn, EV_CONN_CONNECTED, 0);
+		}
+		goto done;
+	}
+
+#ifdef HAVE_SSL
+	if (param.use_ssl) {
+		if (dir == READ && conn->recvq)
+			do_recv(conn);
+		if (dir == WRITE && conn->sendq)
+			do_send(conn);
+	} else
+#endif
+	if (dir == READ) {
+		if (conn->recvq)
+			recv_data(conn, buf, res, -res);
+	} else if (res < 0) {
+		errno = -res;
+		send_failure(conn);
+	} else
+		send_progress(conn, call, res);
+
+	/*
+	 * Operations are one-shot, so keep one in flight for each
+	 * direction that still has work queued.
+	 */
+	if (conn->state >= S_CONNECTED && conn->state < S_CLOSING) {
+		if (conn->sendq && !conn->writing)
+			set_active(conn, WRITE);
+		if (conn->recvq && !conn->reading)
+			set_active(conn, READ);
+	}
+
+      done:
+	if (buf)
+		ring_buf_put(buf);
+	if (call)
+		call_dec_ref(call);
+	conn_dec_ref(conn);
+}
+
+void
+core_loop(void)
+{
+	struct io_uring_cqe *cqe;
+	u_int           head;
+	__u64           tag;
+	Time            timeout;
+	int             res;
+
+	while (running) {
+		++iteration;
+
+		timer_tick();
+		timeout = core_wait_timeout();
+		ring_enter(timeout);
+		if (timeout != 0)
+			timer_refresh();
+
+		head = *ring.cq_khead;
+		while (head != __atomic_load_n(ring.cq_ktail, __ATOMIC_ACQUIRE)) {
+			cqe = &ring.cqes[head & ring.cq_mask];
+			tag = cqe->user_data;
+			res = cqe->res;
+			__atomic_store_n(ring.cq_khead, ++head, __ATOMIC_RELEASE);
+
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+			if (tag == RING_TAG_WAKE) {
+				ssl_pool_complete();
+				ring_poll_wake();
+			} else
+#endif
+			if (tag & RING_TAG_MASK)
+				ring_complete((Conn *) (uintptr_t)
+				    (tag & ~(__u64) RING_TAG_MASK),
+				    (tag & RING_TAG_MASK) - 1, res);
 		}
 	}
-	close(epoll_fd);
 }
 #else
 void
@@ -1588,22 +3124,30 @@ core_loop(void)
 	int        is_readable, is_writable, n, sd, bit, min_i, max_i, i = 0;
 	fd_set     readable, writable;
 	fd_mask    mask;
-	Any_Type   arg;
 	Conn      *conn;
  
 	while (running) {
-	    struct timeval  tv = select_timeout;
+	    struct timeval  tv, *tvp = 0;
+	    Time            timeout;
 
 	    timer_tick();
+	    timeout = core_wait_timeout();
+	    if (timeout >= 0) {
+	        tv.tv_sec = (long) timeout;
+	        tv.tv_usec = (long) ((timeout - tv.tv_sec) * 1e6);
+	        tvp = &tv;
+	    }
 
 	    readable = rdfds;
 	    writable = wrfds;
 	    min_i = min_sd / NFDBITS;
 	    max_i = max_sd / NFDBITS;
 
-	    SYSCALL(SELECT,	n = select(max_sd + 1, &readable, &writable, 0, &tv));
+	    SYSCALL(SELECT,	n = select(max_sd + 1, &readable, &writable, 0, tvp));
 
 	    ++iteration;
+	    if (timeout != 0)
+	        timer_refresh();
 
 	    if (n <= 0) {
 	        if (n < 0) {
@@ -1634,6 +3178,12 @@ core_loop(void)
 	                is_readable = (FD_ISSET(sd, &readable) && FD_ISSET(sd, &rdfds));
 	                is_writable = (FD_ISSET(sd, &writable) && FD_ISSET(sd, &wrfds));
 	                
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+	                if (sd == ssl_wake_fd) {
+	                    if (is_readable)
+	                        ssl_pool_complete();
+	                } else
+#endif
 	                if (is_readable || is_writable) {
 	                    /*
 	                     * only handle sockets that
@@ -1655,8 +3205,7 @@ core_loop(void)
 	                        if (is_writable) {
 				    clear_active(conn, WRITE);
 	                            conn->state = S_CONNECTED;
-	                            arg.l = 0;
-	                            event_signal(EV_CONN_CONNECTED, (Object*)conn, arg);
+	                            conn_signal(conn, EV_CONN_CONNECTED, 0);
 	                        }
 	                    } else {
 	                        if (is_writable && conn->sendq)
@@ -1679,6 +3228,106 @@ core_loop(void)
 }
 #endif
 #endif
+#endif
+
+void
+core_recv_stats(u_wide * ncalls, u_wide * nbytes, u_wide * nmapped)
+{
+	*ncalls = recv_calls;
+	*nbytes = recv_bytes;
+	*nmapped = recv_zc_bytes;
+}
+
+void
+core_tfo_stats(u_long * ntried, u_long * nused)
+{
+	*ntried = tfo_tried;
+	*nused = tfo_used;
+}
+
+void
+core_warm_stats(u_long * nestablished, u_long * nfailed, Time * setup_sum,
+		Time * duration)
+{
+	*nestablished = warm_established;
+	*nfailed = warm_failed;
+	*setup_sum = warm_setup_sum;
+	*duration = warm_time;
+}
+
+/*
+ * Returns whether pooled connection S is still good for a request.  The
+ * server may have closed it while it sat idle; such a connection is
+ * closed here, with its warming flag set again so that the generators
+ * don't take it for one of theirs.
+ */
+int
+core_warm_alive(Conn * s)
+{
+	char            c;
+	ssize_t         n;
+
+#ifdef HAVE_SSL
+	if (param.use_ssl) {
+		/*
+		 * (lets OpenSSL consume session tickets and see close_notify)
+		 */
+		n = SSL_peek(s->ssl, &c, 1);
+		if (n <= 0 && SSL_get_error(s->ssl, n) == SSL_ERROR_WANT_READ)
+			return 1;
+	} else
+#endif
+	{
+		n = recv(s->sd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return 1;
+	}
+	if (DBG > 0)
+		fprintf(stderr, "%s: dropping pooled connection %p\n",
+			prog_name, s);
+	s->warming = 1;
+	core_close(s);
+	return 0;
+}
+
+/*
+ * Opens --warm-conns connections to each server and runs the event loop
+ * until all of them are established (and through the TLS handshake) or
+ * have failed.  The generators then get these connections first from
+ * conn_new().
+ */
+void
+core_warm_up(void)
+{
+	u_long          i, n;
+	Time            start;
+	Conn           *s;
+
+	n = param.warm_conns * conn_num_servers();
+	start = timer_now();
+	warm_pending = n;
+	for (i = 0; i < n; ++i) {
+		/* (not conn_new(): that would hand out the pool) */
+		s = (Conn *) object_new(OBJ_CONN);
+		if (!s) {
+			++warm_failed;
+			--warm_pending;
+			continue;
+		}
+		s->warming = 1;
+		s->basic.time_connect_start = timer_now();
+		core_connect(s);
+	}
+	if (warm_pending > 0)
+		core_loop();
+	warm_time = timer_now() - start;
+
+	/*
+	 * Unless interrupted, the test proper follows.
+	 */
+	if (warm_pending == 0)
+		running = 1;
+}
 
 void
 core_exit(void)
@@ -1705,6 +3354,18 @@ core_exit(void)
 
 		}
 		putchar('\n');
+#ifdef HAVE_IO_URING
+		count = 0;
+		for (i = 0; i < NELEMS(ring_op_name); ++i)
+			count += ring_op_count[i];
+		printf("Ring operations: %u (%.1f per io_uring_enter)\n",
+		    count, syscall_count[SC_IO_URING_ENTER] > 0 ?
+		    (double) count / syscall_count[SC_IO_URING_ENTER] : 0.0);
+		for (i = 0; i < NELEMS(ring_op_name); ++i)
+			printf("\t%s:\t%u ops\n", ring_op_name[i],
+			    ring_op_count[i]);
+		putchar('\n');
+#endif
 	}
 #endif
 }
@@ -43,6 +43,30 @@ extern int core_connect (Conn *conn);
 extern int core_send (Conn *conn, Call *call);
 extern void core_close (Conn *conn);
 
+/* Return how many system calls received reply data so far (NCALLS),
+   how many bytes they received (NBYTES), and how many of those were
+   mapped by TCP_ZEROCOPY_RECEIVE rather than copied (NMAPPED).  */
+extern void core_recv_stats (u_wide *ncalls, u_wide *nbytes,
+			     u_wide *nmapped);
+
+/* Return how many connections were set up for TCP Fast Open (NTRIED)
+   and how many of them got their request accepted in the SYN (NUSED).  */
+extern void core_tfo_stats (u_long *ntried, u_long *nused);
+
+/* Set up the connections of the warm-up phase (see --warm-conns).  */
+extern void core_warm_up (void);
+
+/* Return whether the pooled warm-up connection CONN can still be used.
+   If the server closed it meanwhile, it is closed and 0 returned.  */
+extern int core_warm_alive (Conn *conn);
+
+/* Return how many warm-up connections were established (NESTABLISHED)
+   and how many failed (NFAILED), the sum of the times it took to set
+   them up (SETUP_SUM), and how long the warm-up phase took overall
+   (DURATION).  */
+extern void core_warm_stats (u_long *nestablished, u_long *nfailed,
+			     Time *setup_sum, Time *duration);
+
 extern void core_loop (void);
 extern void core_exit (void);
 
@@ -80,16 +80,21 @@ issue_calls (Conn *conn)
 	call = call_new ();
 	if (call)
 	  {
+	    call->time_intended = conn->time_intended;
+	    call->sched_lag = conn->sched_lag;
 	    core_send (conn, call);
 	    call_dec_ref (call);
 	  }
       }
+  /* later bursts are sent in response to the replies: */
+  conn->time_intended = 0;
 }
 
 static void
 conn_connected (Event_Type et, Conn *conn)
 {
-  assert (et == EV_CONN_CONNECTED && object_is_conn (conn));
+  assert ((et == EV_CONN_CONNECTED || et == EV_CONN_CONNECTING)
+	  && object_is_conn (conn));
 
   issue_calls (conn);
 }
@@ -136,8 +141,15 @@ init (void)
 					    sizeof (Conn_Private_Data));
 
   arg.l = 0;
-  event_register_handler (EV_CONN_CONNECTED, (Event_Handler) conn_connected,
-			  arg);
+#ifdef HAVE_SSL
+  if (param.ssl_early_data)
+    /* queue the first burst early enough to go out as TLS early data */
+    event_register_handler (EV_CONN_CONNECTING,
+			    (Event_Handler) conn_connected, arg);
+  else
+#endif
+    event_register_handler (EV_CONN_CONNECTED,
+			    (Event_Handler) conn_connected, arg);
   event_register_handler (EV_CALL_RECV_STOP, (Event_Handler) call_done, arg);
   event_register_handler (EV_CALL_DESTROYED, (Event_Handler) call_destroyed,
 			  arg);
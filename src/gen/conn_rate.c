@@ -74,6 +74,8 @@ make_conn (Any_Type arg)
   if (!s)
     return -1;
 
+  s->time_intended = rg.due;
+  s->sched_lag = timer_now () - rg.due;
   num_conns_open++;
   if (core_connect (s) == -1) {
     num_conns_generated--;
@@ -84,9 +86,13 @@ make_conn (Any_Type arg)
 }
 
 static void
-destroyed (void)
+destroyed (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type call_arg)
 {
-  Any_Type arg;
+  Conn *s = (Conn *) obj;
+
+  /* Failed connections of the warm-up phase were never ours.  */
+  if (s->warming)
+    return;
 
   if (++num_conns_destroyed >= param.num_conns)
     core_exit ();
@@ -65,6 +65,12 @@ static size_t extra_len;
 
 static size_t method_len, file_len;
 
+static const char *body;	/* --body-file mapped into memory */
+static int body_fd = -1;
+static size_t body_len;
+static char body_hdr[64];	/* "Content-length:" header for BODY */
+static size_t body_hdr_len;
+
 /* A simple module that collects cookies from the server responses and
    includes them in future calls to the server.  */
 
@@ -133,6 +139,12 @@ call_created (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
 
   if (file_len > 0)
     call_append_request_header (c, extra_file, file_len);
+
+  if (body_hdr_len > 0)
+    {
+      call_append_request_header (c, body_hdr, body_hdr_len);
+      call_set_contents_file (c, body, body_len, body_fd, 0);
+    }
 }
 
 
@@ -165,6 +177,26 @@ init (void)
     }
   }
 
+  if (param.body_file)
+    {
+      /* Keep the file open: large bodies are sent from it with
+	 sendfile() rather than copied out of the mapping.  */
+      body_fd = open (param.body_file, O_RDONLY);
+      if (body_fd < 0 || fstat (body_fd, &st) < 0)
+	panic ("%s: can't open body file %s: %s\n",
+	       prog_name, param.body_file, strerror (errno));
+      body_len = st.st_size;
+      if (body_len > 0)
+	{
+	  body = mmap (NULL, body_len, PROT_READ, MAP_SHARED, body_fd, 0);
+	  if (body == (char *) MAP_FAILED)
+	    panic ("%s: can't mmap body file %s: %s\n",
+		   prog_name, param.body_file, strerror (errno));
+	}
+      body_hdr_len = snprintf (body_hdr, sizeof (body_hdr),
+			       "Content-length: %lu\r\n", (u_long) body_len);
+    }
+
   if (param.method)
     method_len = strlen (param.method);
 
@@ -110,6 +110,7 @@ tick (struct Timer *t, Any_Type arg)
 
   while (now > rg->next_time)
     {
+      rg->due = rg->next_time;
       delay = (*rg->next_interarrival_time) (rg);
       if (verbose > 2)
 	fprintf (stderr, "next arrival delay = %.4f\n", delay);
@@ -128,6 +129,7 @@ done (Event_Type type, Object *obj, Any_Type reg_arg, Any_Type call_arg)
 
   if (rg->done)
     return;
+  rg->due = timer_now ();
   rg->done = ((*rg->tick) (rg->arg) < 0);
 }
 
@@ -173,7 +175,7 @@ rate_generator_start (Rate_Generator *rg, Event_Type completion_event)
     /* generate callbacks sequentially: */
     event_register_handler (completion_event, done, arg);
 
-  rg->start = timer_now ();
+  rg->start = rg->due = timer_now ();
   rg->done = ((*rg->tick) (rg->arg) < 0);
 }
 
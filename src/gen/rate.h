@@ -43,6 +43,7 @@ typedef struct Rate_Generator
     Rate_Info *rate;
     Time start;
     Time next_time;
+    Time due;			/* when the current tick was due */
     Any_Type arg;
     struct Timer *timer;
     int (*tick) (Any_Type arg);
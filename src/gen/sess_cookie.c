@@ -126,7 +126,10 @@ call_issue (Event_Type et, Object *obj, Any_Type regarg, Any_Type callarg)
 		 call->id, priv->cookie);
       cpriv->cookie_present = 1;
       memcpy (cpriv->cookie, priv->cookie, priv->cookie_len + 1);
-      call_append_request_header (call, cpriv->cookie, priv->cookie_len);
+      if (call_append_request_header (call, cpriv->cookie,
+				      priv->cookie_len) == 0)
+	call_set_reused (call,
+			 IE_FIRST_HEADER + call->req.num_extra_hdrs - 1);
     }
 }
 
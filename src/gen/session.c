@@ -126,6 +126,8 @@ static size_t conn_private_data_offset = -1;
 static size_t call_private_data_offset = -1;
 static size_t max_qlen;
 
+static void send_calls (Sess *sess, struct Conn_Info *ci);
+
 static void
 create_conn (Sess *sess, struct Conn_Info *ci)
 {
@@ -150,7 +152,8 @@ create_conn (Sess *sess, struct Conn_Info *ci)
   ci->num_sent = 0;		/* (re-)send all pending calls */
 
 #ifdef HAVE_SSL
-  if (param.ssl_reuse && ci->conn->ssl && sess->ssl)
+  if (param.ssl_reuse && !param.ssl_resume.cache_size
+      && ci->conn->ssl && sess->ssl)
     {
       if (DBG > 0)
 	fprintf (stderr, "create_conn: reusing SSL session %p\n",
@@ -161,6 +164,11 @@ create_conn (Sess *sess, struct Conn_Info *ci)
 
   if (core_connect (ci->conn) < 0)
     sess_failure (sess);
+#ifdef HAVE_SSL
+  else if (param.ssl_early_data)
+    /* queue pending calls so the first can go out as TLS early data */
+    send_calls (sess, ci);
+#endif
 }
 
 static void
@@ -176,8 +184,14 @@ send_calls (Sess *sess, struct Conn_Info *ci)
     }
 
   if (!ci->is_connected)
-    /* wait until connection is connected (or has failed)  */
-    return;
+    {
+#ifdef HAVE_SSL
+      /* (calls may go out as TLS early data while handshaking) */
+      if (!param.ssl_early_data)
+#endif
+	/* wait until connection is connected (or has failed)  */
+	return;
+    }
 
   rd = (ci->rd + ci->num_sent) % MAX_PIPED;
 
@@ -235,7 +249,8 @@ conn_connected (Event_Type et, Object *obj, Any_Type regarg, Any_Type callarg)
   ci->is_connected = 1;
 
 #ifdef HAVE_SSL
-  if (param.ssl_reuse && !sess->ssl && ci->conn->ssl)
+  if (param.ssl_reuse && !param.ssl_resume.cache_size
+      && !sess->ssl && ci->conn->ssl)
     {
       sess->ssl = SSL_dup (ci->conn->ssl);
       if (DBG > 0)
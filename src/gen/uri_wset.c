@@ -97,6 +97,7 @@ set_uri (Event_Type et, Call *c)
   memcpy (cp, param.uri, uri_prefix_len);
 
   call_set_uri (c, cp, (buf_end - cp) - 1);
+  call_set_reused (c, IE_URI);	/* the buffer comes with the call */
 
   if (verbose)
     printf ("%s: accessing URI `%s'\n", prog_name, cp);
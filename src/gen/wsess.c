@@ -63,6 +63,7 @@ typedef struct Sess_Private_Data
     u_int num_calls_target;	/* total # of calls desired */
     u_int num_calls_destroyed;	/* # of calls destroyed so far */
     struct Timer *timer;		/* timer for session think time */
+    Time due;			/* when the session was due to start */
   }
 Sess_Private_Data;
 
@@ -96,6 +97,12 @@ issue_calls (Sess *sess, Sess_Private_Data *priv)
 	  sess_failure (sess);
 	  return;
 	}
+      /* only the first call of a session is part of the schedule (it
+	 gets created along with the session): */
+      call->time_intended = priv->due;
+      if (priv->due > 0)
+	call->sched_lag = timer_now () - priv->due;
+      priv->due = 0;
 
       retval = session_issue_call (sess, call);
       call_dec_ref (call);
@@ -174,6 +181,7 @@ sess_create (Any_Type arg)
   priv = SESS_PRIVATE_DATA (sess);
 
   priv->num_calls_target = param.burst_len;
+  priv->due = rg_sess.due;
   issue_calls (sess, SESS_PRIVATE_DATA (sess));
   return 0;
 }
@@ -54,6 +54,10 @@
    # uri is considered to be part of a burst that is sent out after the
    # previous non-burst uri.
    #
+   # A uri may be followed by options: think=X (the user think time
+   # before the burst it starts), method=S, contents=S (the request
+   # body), and class=S (the class --uri-stats reports the request in).
+   #
 
    # session 1 definition (this is a comment)
 
@@ -118,6 +122,7 @@ struct req
     int contents_len;
     char extra_hdrs[50];	/* plenty for "Content-length: 1234567890" */
     int extra_hdrs_len;
+    char *stat_class;		/* class=, for --uri-stats */
   };
 
 typedef struct burst BURST;
@@ -141,18 +146,7 @@ struct Sess_Private_Data
 
     BURST *current_burst;	/* the current burst we're working on */
     REQ *current_req;		/* the current request we're working on */
-  };
-
-/* Methods allowed for a request: */
-enum
-  {
-    HM_DELETE, HM_GET, HM_HEAD, HM_OPTIONS, HM_POST, HM_PUT, HM_PROPFIND, HM_REPORT, HM_TRACE,
-    HM_LEN
-  };
-
-static const char *call_method_name[] =
-  {
-    "DELETE", "GET", "HEAD", "OPTIONS", "POST", "PUT", "PROPFIND", "REPORT", "TRACE"
+    Time due;			/* when the session was due to start */
   };
 
 static size_t sess_private_data_offset;
@@ -219,6 +213,12 @@ issue_calls (Sess *sess, Sess_Private_Data *priv)
 	  sess_failure (sess);
 	  return;
 	}
+      /* only the first call of a session is part of the schedule (it
+	 gets created along with the session): */
+      call->time_intended = priv->due;
+      if (priv->due > 0)
+	call->sched_lag = timer_now () - priv->due;
+      priv->due = 0;
 
       /* fill in the new call: */
       req = priv->current_req;
@@ -236,6 +236,7 @@ issue_calls (Sess *sess, Sess_Private_Data *priv)
 				      req->extra_hdrs_len);
 	  call_set_contents (call, req->contents, req->contents_len);
 	}
+      call->req.stat_class = req->stat_class;
       priv->current_req = req->next;
 
       if (DBG > 0)
@@ -288,6 +289,7 @@ sess_create (Any_Type arg)
     fprintf (stderr, "Starting session, first burst_len = %d\n",
 	     priv->num_calls_target);
 
+  priv->due = rg_sess.due;
   issue_calls (sess, SESS_PRIVATE_DATA (sess));
   return 0;
 }
@@ -451,7 +453,7 @@ parse_config (void)
 	{
 	  if (sscanf (this_arg, "method=%s", method_str) == 1)
 	    {
-	      for (i = 0; i < HM_LEN; i++)
+	      for (i = 0; i < HM_OTHER; i++)
 		{
 		  if (!strncmp (method_str,call_method_name[i],
 				strlen (call_method_name[i])))
@@ -460,12 +462,14 @@ parse_config (void)
 		      break;
 		    }
 		}
-	      if (i == HM_LEN)
+	      if (i == HM_OTHER)
 		panic ("%s: did not recognize method '%s' in %s\n",
 		       prog_name, method_str, param.wsesslog.file);  
 	    }
 	  else if (sscanf (this_arg, "think=%lf", &think_time) == 1)
 	    current_burst->user_think_time = think_time;
+	  else if (strncmp (this_arg, "class=", 6) == 0 && this_arg[6])
+	    sptr->current_req->stat_class = strdup (this_arg + 6);
 	  else if (sscanf (this_arg, "contents=%s", contents) == 1)
 	    {
 	      /* this is tricky since contents might be a quoted
@@ -608,6 +612,8 @@ parse_config (void)
 			     call_method_name[reqptr->method]);
 		  if (reqptr->contents != NULL)
 		    fprintf (stderr, " contents='%s'", reqptr->contents);
+		  if (reqptr->stat_class != NULL)
+		    fprintf (stderr, " class=%s", reqptr->stat_class);
 		  fprintf (stderr, "\n");
 		}
 	    }
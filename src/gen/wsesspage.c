@@ -100,6 +100,7 @@ typedef struct Sess_Private_Data
 	char uri[1];		/* really URI_LEN+1 bytes... */
       }
     *uri_list;
+    Time due;			/* when the session was due to start */
   }
 Sess_Private_Data;
 
@@ -141,6 +142,12 @@ issue_calls (Sess *sess, Sess_Private_Data *priv)
 	  sess_failure (sess);
 	  return;
 	}
+      /* only the first call of a session is part of the schedule (it
+	 gets created along with the session): */
+      call->time_intended = priv->due;
+      if (priv->due > 0)
+	call->sched_lag = timer_now () - priv->due;
+      priv->due = 0;
       if (embedded)
 	{
 	  el = priv->uri_list;
@@ -149,6 +156,8 @@ issue_calls (Sess *sess, Sess_Private_Data *priv)
 	  cpriv = CALL_PRIVATE_DATA (call);
 	  cpriv->to_free = el;
 	  call_set_uri (call, el->uri, el->uri_len);
+	  /* EL is freed along with the call: */
+	  call_set_reused (call, IE_URI);
 	}
 
       if (verbose > 1)
@@ -488,6 +497,7 @@ sess_create (Any_Type arg)
 
   priv = SESS_PRIVATE_DATA (sess);
 
+  priv->due = rg_sess.due;
   issue_calls (sess, SESS_PRIVATE_DATA (sess));
   return 0;
 }
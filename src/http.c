@@ -39,6 +39,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+# include <immintrin.h>
+#endif
 
 #include <generic_types.h>
 
@@ -50,60 +53,242 @@
 #include <httperf.h>
 #include <http.h>
 
-/* Read a CRLF terminated line of characters into c->reply.line.
+/* Header lines that lie wholly within the buffer that was read are
+   parsed in place.  Only a line that spans reads is copied, into a
+   line buffer that the connection borrows from a pool while it holds
+   the partial line.  */
+#define LINE_BUF_SIZE	256
+
+struct line_buf
+  {
+    struct line_buf *next;
+    size_t size;
+  };
+
+static struct line_buf *line_buf_pool;
+
+/* Make the line buffer of S at least NEEDED bytes large.  Returns 0 if
+   it cannot grow that large.  */
+static int
+grow_line (Conn *s, size_t needed)
+{
+  struct line_buf *lb;
+  size_t size;
+  char *buf;
+
+  if (needed > MAX_HDR_LINE_LEN)
+    needed = MAX_HDR_LINE_LEN;
+
+  if (!s->line_size && line_buf_pool)
+    {
+      lb = line_buf_pool;
+      line_buf_pool = lb->next;
+      s->line_buf = (char *) lb;
+      s->line_size = lb->size;
+    }
+  if (s->line_size >= needed)
+    return 1;
+
+  size = s->line_size ? s->line_size : LINE_BUF_SIZE;
+  while (size < needed)
+    size *= 2;
+  if (size > MAX_HDR_LINE_LEN)
+    size = MAX_HDR_LINE_LEN;
+
+  buf = realloc (s->line_buf, size);
+  if (!buf)
+    {
+      fprintf (stderr, "%s.grow_line: %s\n", prog_name, strerror (errno));
+      exit (1);
+    }
+  s->line_buf = buf;
+  s->line_size = size;
+  return size >= needed;
+}
+
+void
+http_release_line (Conn *s)
+{
+  struct line_buf *lb;
+
+  s->line.iov_base = 0;
+  s->line.iov_len = 0;
+  if (!s->line_size)
+    return;
+
+  lb = (struct line_buf *) s->line_buf;
+  lb->size = s->line_size;
+  lb->next = line_buf_pool;
+  line_buf_pool = lb;
+
+  s->line_buf = 0;
+  s->line_size = 0;
+}
+
+/* Find the first '\n' in [P, END).  If COLONP is not null, the first
+   ':' before that is stored there (or null if there is none).  Returns
+   null if there is no '\n'.  */
+static const char *
+scan_line (const char *p, const char *end, const char **colonp)
+{
+  const char *colon = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+  const __m128i lf16 = _mm_set1_epi8 ('\n'), colon16 = _mm_set1_epi8 (':');
+  u_int lf, co;
+# ifdef __AVX2__
+  const __m256i lf32 = _mm256_set1_epi8 ('\n');
+  const __m256i colon32 = _mm256_set1_epi8 (':');
+
+  for (; end - p >= 32; p += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) p);
+
+      lf = _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, lf32));
+      co = colon ? 0 : _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, colon32));
+      if (co && (!lf || __builtin_ctz (co) < __builtin_ctz (lf)))
+	colon = p + __builtin_ctz (co);
+      if (lf)
+	{
+	  p += __builtin_ctz (lf);
+	  goto found;
+	}
+    }
+# endif
+  for (; end - p >= 16; p += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+
+      lf = _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, lf16));
+      co = colon ? 0 : _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, colon16));
+      if (co && (!lf || __builtin_ctz (co) < __builtin_ctz (lf)))
+	colon = p + __builtin_ctz (co);
+      if (lf)
+	{
+	  p += __builtin_ctz (lf);
+	  goto found;
+	}
+    }
+#endif
+  for (; p < end; ++p)
+    if (*p == '\n')
+      goto found;
+    else if (*p == ':' && !colon)
+      colon = p;
+  p = 0;
+
+ found:
+  if (colonp)
+    *colonp = colon;
+  return p;
+}
+
+/* Read a CRLF terminated line of characters into c->conn->line.
    Returns 1 when the line is complete, 0 when the line is incomplete
-   and more data is needed.  */
+   and more data is needed.  The line is '\0' terminated and may point
+   into *BUFP, so it is valid only until the caller returns.  If COLONP
+   is not null, it is set to the first ':' in the line (or null).  */
 static int
-get_line (Call *c, char **bufp, size_t *buf_lenp)
+get_line (Call *c, char **bufp, size_t *buf_lenp, const char **colonp)
 {
-  size_t to_copy, buf_len = *buf_lenp;
+  size_t to_copy, len, buf_len = *buf_lenp;
   Conn *s = c->conn;
-  char *buf = *bufp;
+  char *buf = *bufp, *line;
   const char *eol;
-  int has_lf;
 
   if (buf_len <= 0)
     return 0;
 
-  /* Note that core.c guarantees that BUF is '\0' terminated. */
-  eol = strchr (buf, '\n');
-  if (eol)
-    ++eol;
+  eol = scan_line (buf, buf + buf_len, colonp);
+  if (eol && s->line.iov_len == 0)
+    {
+      /* The whole line is in BUF, no need to copy it.  Since core.c
+	 guarantees that BUF can be '\0' terminated, overwriting the
+	 '\n' cannot run past its end.  */
+      line = buf;
+      len = eol - buf;
+      *bufp = (char *) eol + 1;
+      *buf_lenp = buf_len - (len + 1);
+    }
   else
-    eol = buf + buf_len;
-
-  to_copy = eol - buf;
-  buf_len -= to_copy;
-  if (s->line.iov_len + to_copy >= sizeof (s->line_buf))
     {
-      fprintf (stderr,
-	       "%s.get_line: truncating header from %lu to %lu bytes\n",
-	       prog_name, (u_long) (s->line.iov_len + to_copy),
-	       (u_long) sizeof (s->line_buf));
-      to_copy = sizeof (s->line_buf) - 1 - s->line.iov_len;
+      to_copy = eol ? (size_t) (eol + 1 - buf) : buf_len;
+      *bufp = buf + to_copy;
+      *buf_lenp = buf_len - to_copy;
+      if (s->line.iov_len + to_copy >= s->line_size
+	  && !grow_line (s, s->line.iov_len + to_copy + 1))
+	{
+	  fprintf (stderr,
+		   "%s.get_line: truncating header from %lu to %lu bytes\n",
+		   prog_name, (u_long) (s->line.iov_len + to_copy),
+		   (u_long) s->line_size);
+	  to_copy = s->line_size - 1 - s->line.iov_len;
+	}
+      memcpy (s->line_buf + s->line.iov_len, buf, to_copy);
+      s->line.iov_base = s->line_buf;
+      s->line.iov_len += to_copy;
+
+      line = s->line_buf;
+      len = s->line.iov_len;
+      if (len > 0 && line[len - 1] == '\n')
+	--len;
+      else if (len < MAX_HDR_LINE_LEN - 1)
+	return 0;
+
+      if (colonp)
+	scan_line (line, line + len, colonp);
     }
-  memcpy ((char *) s->line.iov_base + s->line.iov_len, buf, to_copy);
-  s->line.iov_len += to_copy;
 
-  has_lf = ((char *) s->line.iov_base)[s->line.iov_len - 1] == '\n';
-
-  *bufp = (char *) eol;
-  *buf_lenp = buf_len;
+  /* We got a full header line.  Chop off \r at the tail if
+     necessary.  */
+  if (len > 0 && line[len - 1] == '\r')
+    --len;
+  line[len] = '\0';
+  s->line.iov_base = line;
+  s->line.iov_len = len;
+  return 1;
+}
 
-  if (has_lf || s->line.iov_len == sizeof (s->line_buf) - 1)
+/* Does a reply to a request with the given method carry a message
+   body (subject to the status code)?  HEAD never includes an
+   entity.  */
+static const char method_has_body[HM_NUM_METHODS] =
+  {
+    1,	/* HM_GET */
+    0,	/* HM_HEAD */
+    1,	/* HM_POST */
+    1,	/* HM_PUT */
+    1,	/* HM_DELETE */
+    1,	/* HM_OPTIONS */
+    1,	/* HM_TRACE */
+    1,	/* HM_CONNECT */
+    1,	/* HM_PATCH */
+    1,	/* HM_PROPFIND */
+    1,	/* HM_REPORT */
+    1	/* HM_OTHER */
+  };
+
+#define IS_DIGIT(c)	((u_int) ((c) - '0') < 10)
+
+/* Parse the status line in LINE of length LEN.  Returns 0 if it is
+   not well-formed.  */
+static int
+scan_status_line (const char *line, size_t len,
+		  u_int *major, u_int *minor, u_int *status)
+{
+  /* Virtually every server sends "HTTP/d.d ddd ...": */
+  if (len >= 12 && memcmp (line, "HTTP/", 5) == 0
+      && IS_DIGIT (line[5]) && line[6] == '.' && IS_DIGIT (line[7])
+      && line[8] == ' '
+      && IS_DIGIT (line[9]) && IS_DIGIT (line[10]) && IS_DIGIT (line[11])
+      && (len == 12 || line[12] == ' '))
     {
-      /* We got a full header line.  Chop off \r\n at the tail if
-	 necessary.  */
-      if (((char *) s->line.iov_base)[s->line.iov_len - 1] == '\n')
-	{
-	  --s->line.iov_len;
-	  if (((char *) s->line.iov_base)[s->line.iov_len - 1] == '\r')
-	    --s->line.iov_len;
-	}
-      ((char *) s->line.iov_base)[s->line.iov_len] = '\0';
+      *major = line[5] - '0';
+      *minor = line[7] - '0';
+      *status = (100*(line[9] - '0') + 10*(line[10] - '0')
+		 + (line[11] - '0'));
       return 1;
     }
-  return 0;
+  return sscanf (line, "HTTP/%u.%u %u ", major, minor, status) == 3;
 }
 
 static void
@@ -119,22 +304,23 @@ parse_status_line (Call *c, char **bufp, size_t *buf_lenp)
   /* default to "infinite" content length: */
   s->content_length = ~(size_t) 0;
 
-  if (!get_line (c, bufp, buf_lenp))
+  if (!get_line (c, bufp, buf_lenp, 0))
     return;
 
   buf = c->conn->line.iov_base;
-  if (sscanf (buf, "HTTP/%u.%u %u ", &major, &minor, &status) == 3)
+  if (scan_status_line (buf, c->conn->line.iov_len, &major, &minor, &status))
     {
       c->reply.version = 0x10000*major + minor;
       c->reply.status = status;
     }
   else
     {
+      /* Status 0 has the reply counted as invalid rather than as a
+	 server error.  */
       c->reply.version = 0x10000;		/* default to 1.0 */
-      c->reply.status = 599;
-      if (c->reply.status == 599)
-	fprintf (stderr, "%s.parse_status_line: invalid status line `%s'!!\n",
-		 prog_name, buf);
+      c->reply.status = status = 0;
+      fprintf (stderr, "%s.parse_status_line: invalid status line `%s'!!\n",
+	       prog_name, buf);
     }
   if (DBG > 0)
     fprintf (stderr,
@@ -142,11 +328,11 @@ parse_status_line (Call *c, char **bufp, size_t *buf_lenp)
 	     c->id, c->reply.version / 0x10000, c->reply.version & 0xffff,
 	     c->reply.status);
 
-  /* Determine whether we should be expecting a message body.  HEAD
-     never includes an entity.  For other methods, things depend on
-     the status code.  */
+  /* Determine whether we should be expecting a message body.  This
+     depends on the method and, for methods that allow one, on the
+     status code.  */
 
-  if (strcmp ((char *) c->req.iov[IE_METHOD].iov_base, "HEAD") == 0)
+  if (!method_has_body[c->req.method_id])
     s->has_body = 0;
   else
     {
@@ -180,6 +366,9 @@ parse_status_line (Call *c, char **bufp, size_t *buf_lenp)
 	case 5: /* server errors */
 	  break;
 
+	case 0: /* invalid status line, reported above */
+	  break;
+
 	default:
 	  fprintf (stderr, "%s.parse_status_line: bad status %u\n",
 		   prog_name, status);
@@ -201,11 +390,12 @@ static void
 parse_headers (Call *c, char **bufp, size_t *buf_lenp)
 {
   char *hdr, *buf_start = *bufp;
+  const char *colon;
   Conn *s = c->conn;
   size_t hdr_len;
   Any_Type arg;
 
-  while (get_line (c, bufp, buf_lenp) > 0)
+  while (get_line (c, bufp, buf_lenp, &colon) > 0)
     {
       hdr = s->line.iov_base;
       hdr_len = s->line.iov_len;
@@ -222,17 +412,18 @@ parse_headers (Call *c, char **bufp, size_t *buf_lenp)
 	    else
 	      s->state = S_REPLY_DATA;
 	  else if (s->state == S_REPLY_CONTINUE)
-	    s->state = S_REPLY_HEADER;
+	    s->state = S_REPLY_STATUS;	/* the real reply follows */
 	  else
 	    s->state = S_REPLY_DONE;
 	  break;
 	}
 
-      /* process line as a regular header: */
-      switch (tolower (*hdr))
+      /* process line as a regular header (the name length tells
+	 the interesting ones apart cheaply): */
+      switch (colon ? colon - hdr : 0)
 	{
-	case 'c':
-	  if (strncasecmp (hdr, "content-length:", 15) == 0)
+	case 14:
+	  if (strncasecmp (hdr, "content-length", 14) == 0)
 	    {
 	      hdr += 15;
 	      s->content_length = strtoul (hdr, 0, 10);
@@ -241,8 +432,8 @@ parse_headers (Call *c, char **bufp, size_t *buf_lenp)
 	    }
 	  break;
 
-	case 't':
-	  if (strncasecmp (hdr, "transfer-encoding:", 18) == 0)
+	case 17:
+	  if (strncasecmp (hdr, "transfer-encoding", 17) == 0)
 	    {
 	      hdr += 18;
 	      while (isspace (*hdr))
@@ -272,7 +463,7 @@ parse_footers (Call *c, char **bufp, size_t *buf_lenp)
   size_t hdr_len;
   Any_Type arg;
 
-  while (get_line (c, bufp, buf_lenp) > 0)
+  while (get_line (c, bufp, buf_lenp, 0) > 0)
     {
       hdr = s->line.iov_base;
       hdr_len = s->line.iov_len;
@@ -319,6 +510,38 @@ parse_data (Call *c, char **bufp, size_t *buf_lenp)
   return (buf_len == bytes_needed);
 }
 
+size_t
+http_discardable_bytes (Call *c)
+{
+  Conn *s = c->conn;
+
+  if (s->state != S_REPLY_DATA || s->content_length == ~(size_t) 0
+      || event_has_handler (EV_CALL_RECV_DATA)
+      || event_has_handler (EV_CALL_RECV_RAW_DATA))
+    return 0;
+  return s->content_length - c->reply.content_bytes;
+}
+
+size_t
+http_body_bytes (Call *c)
+{
+  Conn *s = c->conn;
+
+  if (s->state != S_REPLY_DATA)
+    return 0;
+  return s->content_length - c->reply.content_bytes;
+}
+
+void
+http_discard_reply_bytes (Call *c, size_t n)
+{
+  Conn *s = c->conn;
+
+  c->reply.content_bytes += n;
+  if (c->reply.content_bytes == s->content_length)
+    s->state = S_REPLY_DONE;
+}
+
 static void
 xfer_chunked  (Call *c, char **bufp, size_t *buf_lenp)
 {
@@ -331,7 +554,7 @@ xfer_chunked  (Call *c, char **bufp, size_t *buf_lenp)
       if (c->reply.content_bytes >= s->content_length)
 	{
 	  /* need to parse next chunk length line: */
-	  if (!get_line (c, bufp, buf_lenp))
+	  if (!get_line (c, bufp, buf_lenp, 0))
 	    return;				/* need more data */
 	  if (s->line.iov_len == 0)
 	    continue;				/* skip over empty line */
@@ -400,7 +623,7 @@ http_process_reply_bytes (Call *c, char **bufp, size_t *buf_lenp)
 	  break;
 
 	case S_REPLY_DONE:
-	  return;
+	  goto done;
 
 	default:
 	  fprintf (stderr, "%s.http_process_reply_bytes: bad state %d\n",
@@ -409,4 +632,9 @@ http_process_reply_bytes (Call *c, char **bufp, size_t *buf_lenp)
 	}
     }
   while (*buf_lenp > 0 && s->state < S_CLOSING);
+
+ done:
+  /* Hang on to the line buffer only while a line is incomplete: */
+  if (s->line.iov_len == 0)
+    http_release_line (s);
 }
@@ -36,4 +36,21 @@
 
 extern void http_process_reply_bytes (Call *c, char **buf, size_t *buf_len);
 
+/* Return the number of bytes of C's reply body that can be consumed
+   without being looked at, i.e., without anyone handling
+   EV_CALL_RECV_RAW_DATA or EV_CALL_RECV_DATA.  */
+extern size_t http_discardable_bytes (Call *c);
+
+/* Account for N bytes of C's reply body having been consumed without
+   being read, where N is at most http_discardable_bytes (C).  */
+extern void http_discard_reply_bytes (Call *c, size_t n);
+
+/* Return the number of bytes of C's reply body that are still to come
+   and that http_process_reply_bytes() passes on as they are, without
+   parsing them or relying on them being '\0'-terminated.  */
+extern size_t http_body_bytes (Call *c);
+
+/* Return the line buffer of connection S (if any) to the pool.  */
+extern void http_release_line (Conn *s);
+
 #endif /* http_h */
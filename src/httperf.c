@@ -70,6 +70,7 @@
 #endif
 
 #include <sys/time.h>
+#include <sys/wait.h>
 
 #include <generic_types.h>
 #include <sys/resource.h>	/* after sys/types.h for BSD (in generic_types.h) */
@@ -85,6 +86,7 @@
 
 #ifdef HAVE_SSL
 #  include <openssl/rand.h>
+#  include <ssl_cache.h>
 #endif
 
 #define RATE_INTERVAL	5.0
@@ -109,17 +111,39 @@ int             debug_level;
 
 static Time     perf_sample_start;
 
+/*
+ * With --threads, the parent forks one worker per event loop.  Each worker
+ * writes a Worker_Report followed by the state of its stat collectors to
+ * the pipe WORKER_FD once its test is done.
+ */
+typedef struct Worker_Report {
+	Time            time_start;
+	Time            time_stop;
+	struct rusage   rusage_start;
+	struct rusage   rusage_stop;
+} Worker_Report;
+
+static int      worker_fd = -1;
+static pid_t   *worker_pid;
+static int     *worker_rfd;
+static u_int    num_workers;
+
 static struct option longopts[] = {
 	{"add-header", required_argument, (int *) &param.additional_header, 0},
 	{"add-header-file", required_argument, (int *) &param.additional_header_file, 0 },
+	{"body-file", required_argument, (int *) &param.body_file, 0},
+	{"bulk-recv", required_argument, (int *) &param.bulk_recv, 0},
 	{"burst-length", required_argument, (int *) &param.burst_len, 0},
+	{"busy-poll", required_argument, (int *) &param.busy_poll, 0},
 	{"client", required_argument, (int *) &param.client, 0},
 	{"close-with-reset", no_argument, &param.close_with_reset, 1},
 	{"debug", required_argument, 0, 'd'},
+	{"edge-triggered", no_argument, &param.edge_triggered, 1},
 	{"failure-status", required_argument, &param.failure_status, 0},
 	{"help", no_argument, 0, 'h'},
 	{"hog", no_argument, &param.hog, 1},
 	{"http-version", required_argument, (int *) &param.http_version, 0},
+	{"hugepages", no_argument, &param.hugepages, 1},
 	{"max-connections", required_argument, (int *) &param.max_conns, 0},
 	{"max-piped-calls", required_argument, (int *) &param.max_piped, 0},
 	{"method", required_argument, (int *) &param.method, 0},
@@ -127,8 +151,11 @@ static struct option longopts[] = {
 	{"no-host-hdr", no_argument, &param.no_host_hdr, 1},
 	{"num-calls", required_argument, (int *) &param.num_calls, 0},
 	{"num-conns", required_argument, (int *) &param.num_conns, 0},
+	{"percentiles", required_argument, (int *) &param.percentiles, 0},
 	{"period", required_argument, (int *) &param.rate.mean_iat, 0},
+	{"phase-stats", no_argument, &param.phase_stats, 1},
 	{"port", required_argument, (int *) &param.port, 0},
+	{"prealloc", required_argument, (int *) &param.prealloc, 0},
 	{"print-reply", optional_argument, &param.print_reply, 0},
 	{"print-request", optional_argument, &param.print_request, 0},
 	{"rate", required_argument, (int *) &param.rate, 0},
@@ -140,12 +167,19 @@ static struct option longopts[] = {
 	{"server-name", required_argument, (int *) &param.server_name, 0},
 	{"servers", required_argument, (int *) &param.servers, 0},
 	{"uri", required_argument, (int *) &param.uri, 0},
+	{"uri-class", required_argument, (int *) &param.uri_stats.classes, 0},
+	{"uri-stats", required_argument, (int *) &param.uri_stats, 0},
+	{"zerocopy", required_argument, (int *) &param.zerocopy, 0},
 	{"session-cookies", no_argument, (int *) &param.session_cookies, 1},
 #ifdef HAVE_SSL
 	{"ssl", no_argument, &param.use_ssl, 1},
 	{"ssl-ciphers", required_argument, (int *) &param.ssl_cipher_list, 0},
 	{"tls-server-name", required_argument, (int *) &param.tls_server_name, 0},
 	{"ssl-no-reuse", no_argument, &param.ssl_reuse, 0},
+	{"ssl-ktls", no_argument, &param.ssl_ktls, 1},
+	{"ssl-resume", required_argument, (int *) &param.ssl_resume, 0},
+	{"ssl-early-data", no_argument, &param.ssl_early_data, 1},
+	{"ssl-threads", required_argument, (int *) &param.ssl_threads, 0},
         {"ssl-certificate", required_argument, (int *) &param.ssl_cert,     0},
         {"ssl-key",      required_argument, (int *) &param.ssl_key,         0},
         {"ssl-verify",   optional_argument, (int *) &param.ssl_verify,      0},
@@ -153,11 +187,14 @@ static struct option longopts[] = {
         {"ssl-ca-path",  required_argument, (int *) &param.ssl_ca_path,     0},
         {"ssl-protocol", required_argument, &param.ssl_protocol,            0},
 #endif
+	{"tfo", no_argument, &param.tfo, 1},
 	{"think-timeout", required_argument, (int *) &param.think_timeout, 0},
+	{"threads", required_argument, (int *) &param.num_threads, 0},
 	{"timeout", required_argument, (int *) &param.timeout, 0},
 	{"use-timer-cache", no_argument, &param.use_timer_cache, 1},
 	{"verbose", no_argument, 0, 'v'},
 	{"version", no_argument, 0, 'V'},
+	{"warm-conns", required_argument, (int *) &param.warm_conns, 0},
 	{"periodic-stats", no_argument, 0, 'n'},
 	{"wlog", required_argument, (int *) &param.wlog, 0},
 	{"wsess", required_argument, (int *) &param.wsess, 0},
@@ -171,26 +208,34 @@ static void
 usage(void)
 {
 	printf("Usage: %s "
-	       "[-hdvV] [--add-header S] [--burst-length N] [--client N/N]\n"
-	       "\t[--close-with-reset] [--debug N] [--failure-status N]\n"
-	       "\t[--help] [--hog] [--http-version S] [--max-connections N]\n"
+	       "[-hdvV] [--add-header S] [--body-file F] [--bulk-recv N]\n"
+	       "\t[--burst-length N] [--busy-poll X] [--client N/N] [--close-with-reset] [--debug N]\n"
+	       "\t[--edge-triggered] [--failure-status N]\n"
+	       "\t[--help] [--hog] [--http-version S] [--hugepages]\n"
+	       "\t[--max-connections N]\n"
 	       "\t[--max-piped-calls N] [--method S] [--no-host-hdr]\n"
-	       "\t[--num-calls N] [--num-conns N] [--session-cookies]\n"
+	       "\t[--num-calls N] [--num-conns N] [--percentiles L] [--session-cookies]\n"
 	       "\t[--period [d|u|e]T1[,T2]|[v]T1,D1[,T2,D2]...[,Tn,Dn]\n"
+	       "\t[--phase-stats]\n"
+	       "\t[--prealloc N[,N,N]]\n"
 	       "\t[--print-reply [header|body]] [--print-request [header|body]]\n"
 	       "\t[--rate X] [--recv-buffer N] [--retry-on-failure] [--send-buffer N]\n"
 	       "\t[--server S|--servers file] [--server-name S] [--port N] [--uri S] "
 	       "[--myaddr S]\n"
+	       "\t[--uri-stats N[,N]] [--uri-class L]\n"
 #ifdef HAVE_SSL
-	       "\t[--ssl] [--ssl-ciphers L] [--ssl-no-reuse]\n"
+	       "\t[--ssl] [--ssl-ciphers L] [--ssl-no-reuse] [--ssl-ktls]\n"
+	       "\t[--ssl-resume X[,N]] [--ssl-early-data] [--ssl-threads N]\n"
                "\t[--ssl-certificate file] [--ssl-key file]\n"
                "\t[--ssl-ca-file file] [--ssl-ca-path path]\n"
                "\t[--ssl-verify [yes|no]] [--ssl-protocol S]\n"
 #endif
-	       "\t[--think-timeout X] [--timeout X] [--verbose] [--version]\n"
+	       "\t[--tfo] [--think-timeout X] [--threads N] [--timeout X]\n"
+	       "\t[--verbose]\n"
+	       "\t[--version] [--warm-conns N]\n"
 	       "\t[--wlog y|n,file] [--wsess N,N,X] [--wsesslog N,X,file]\n"
 	       "\t[--wset N,X]\n"
-	       "\t[--runtime X]\n"
+	       "\t[--runtime X] [--zerocopy N]\n"
 	       "\t[--use-timer-cache]\n"
 	       "\t[--periodic-stats]\n", prog_name);
 }
@@ -211,6 +256,206 @@ no_op(void)
 {
 }
 
+void
+write_fully(int fd, const void *buf, size_t len)
+{
+	const char     *cp = buf;
+	ssize_t         n;
+
+	while (len > 0) {
+		n = write(fd, cp, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			panic("%s: write to parent failed: %s\n", prog_name,
+			      strerror(errno));
+		}
+		cp += n;
+		len -= n;
+	}
+}
+
+/*
+ * Reads exactly LEN bytes from FD.  Returns -1 if the writer went away
+ * before all of them arrived.
+ */
+int
+read_fully(int fd, void *buf, size_t len)
+{
+	char           *cp = buf;
+	ssize_t         n;
+
+	while (len > 0) {
+		n = read(fd, cp, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		cp += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static u_long
+worker_share(u_long total, u_int i, u_int n)
+{
+	return total / n + (i < total % n);
+}
+
+/*
+ * Turns this process into worker I of N: it generates 1/N of the
+ * arrivals and behaves as client I of N for the purpose of seeding the
+ * random number generators and partitioning the working set.
+ */
+static void
+worker_setup(u_int i, u_int n)
+{
+	int             k;
+
+	param.client.id = param.client.id * n + i;
+	param.client.num_clients *= n;
+
+	param.num_conns = worker_share(param.num_conns, i, n);
+	param.warm_conns = worker_share(param.warm_conns, i, n);
+	param.wsess.num_sessions = worker_share(param.wsess.num_sessions, i, n);
+	param.wsesspage.num_sessions =
+	    worker_share(param.wsesspage.num_sessions, i, n);
+	param.wsesslog.num_sessions =
+	    worker_share(param.wsesslog.num_sessions, i, n);
+
+	param.rate.rate_param /= n;
+	param.rate.mean_iat *= n;
+	param.rate.min_iat *= n;
+	param.rate.max_iat *= n;
+	for (k = 0; k < param.rate.numRates; ++k)
+		param.rate.iat[k] *= n;
+}
+
+static void
+stop_workers(int sig)
+{
+	u_int           i;
+
+	for (i = 0; i < num_workers; ++i)
+		kill(worker_pid[i], SIGINT);
+}
+
+/*
+ * Forks the workers.  Returns 0 in a worker (which then runs the test
+ * as usual) and 1 in the parent.
+ */
+static int
+spawn_workers(void)
+{
+	u_long          work;
+	int             fd[2];
+	pid_t           pid;
+	u_int           i, k, n;
+
+	if (param.wsesslog.num_sessions)
+		work = param.wsesslog.num_sessions;
+	else if (param.wsesspage.num_sessions)
+		work = param.wsesspage.num_sessions;
+	else if (param.wsess.num_sessions)
+		work = param.wsess.num_sessions;
+	else
+		work = param.num_conns;
+
+	n = param.num_threads;
+	if (work > 0 && n > work)
+		n = work;
+
+	worker_pid = calloc(n, sizeof(worker_pid[0]));
+	worker_rfd = calloc(n, sizeof(worker_rfd[0]));
+	if (!worker_pid || !worker_rfd)
+		panic("%s: out of memory\n", prog_name);
+
+	fflush(stdout);
+	for (i = 0; i < n; ++i) {
+		if (pipe(fd) < 0)
+			panic("%s: pipe() failed: %s\n", prog_name,
+			      strerror(errno));
+		pid = fork();
+		if (pid < 0)
+			panic("%s: fork() failed: %s\n", prog_name,
+			      strerror(errno));
+		if (pid == 0) {
+			/*
+			 * Workers get their own process group so that an
+			 * interrupt reaches them only via the parent.
+			 */
+			setpgid(0, 0);
+			close(fd[0]);
+			for (k = 0; k < i; ++k)
+				close(worker_rfd[k]);
+			free(worker_pid);
+			free(worker_rfd);
+			worker_pid = NULL;
+			num_workers = 0;
+			worker_fd = fd[1];
+			worker_setup(i, n);
+			return 0;
+		}
+		close(fd[1]);
+		worker_pid[i] = pid;
+		worker_rfd[i] = fd[0];
+		++num_workers;
+	}
+	return 1;
+}
+
+static void
+rusage_accumulate(struct rusage *sum, const struct rusage *start,
+		  const struct rusage *stop)
+{
+	struct timeval  tv;
+
+	timersub(&stop->ru_utime, &start->ru_utime, &tv);
+	timeradd(&sum->ru_utime, &tv, &sum->ru_utime);
+	timersub(&stop->ru_stime, &start->ru_stime, &tv);
+	timeradd(&sum->ru_stime, &tv, &sum->ru_stime);
+}
+
+/*
+ * Waits for the workers and merges their results into the parent's
+ * stat collectors.  The test is taken to span from the earliest worker
+ * start to the latest worker stop; CPU time is the sum over all workers.
+ */
+static void
+collect_workers(Stat_Collector **stat, int num_stats)
+{
+	Worker_Report   report;
+	u_int           i, num_reports = 0;
+	int             j, status;
+
+	memset(&test_rusage_start, 0, sizeof(test_rusage_start));
+	memset(&test_rusage_stop, 0, sizeof(test_rusage_stop));
+
+	for (i = 0; i < num_workers; ++i) {
+		if (read_fully(worker_rfd[i], &report, sizeof(report)) < 0)
+			fprintf(stderr,
+				"%s: worker %u exited without reporting\n",
+				prog_name, i);
+		else {
+			if (num_reports++ == 0
+			    || report.time_start < test_time_start)
+				test_time_start = report.time_start;
+			if (report.time_stop > test_time_stop)
+				test_time_stop = report.time_stop;
+			rusage_accumulate(&test_rusage_stop,
+					  &report.rusage_start,
+					  &report.rusage_stop);
+			for (j = 0; j < num_stats; ++j)
+				if (stat[j]->merge)
+					(*stat[j]->merge) (worker_rfd[i]);
+		}
+		close(worker_rfd[i]);
+	}
+	for (i = 0; i < num_workers; ++i)
+		waitpid(worker_pid[i], &status, 0);
+}
+
 static void
 perf_sample(struct Timer *t, Any_Type regarg)
 {
@@ -235,7 +480,7 @@ main(int argc, char **argv)
 	    call_seq;
 	extern Load_Generator wsess, wsesslog, wsesspage, sess_cookie, misc;
 	extern Stat_Collector stats_basic, session_stat;
-	extern Stat_Collector stats_print_reply;
+	extern Stat_Collector stats_print_reply, phase_stat, uri_stat;
 	extern char    *optarg;
 	int             session_workload = 0;
 	int             num_gen = 3;
@@ -245,15 +490,16 @@ main(int argc, char **argv)
 		&conn_rate,
 	};
 	int             num_stats = 1;
-	Stat_Collector *stat[3] = {
+	Stat_Collector *stat[5] = {
 		&stats_basic
 	};
 	int             i, ch, longindex;
 	u_int           minor, major;
-	char           *end, *name;
+	char           *end, *name, *cp;
 	Any_Type        arg;
 	void           *flag;
 	Time            t;
+	long            page;
 
 	int             numRates = 0;
 
@@ -284,6 +530,12 @@ main(int argc, char **argv)
 	param.send_buffer_size = 4096;
 	param.recv_buffer_size = 16384;
 	param.rate.dist = DETERMINISTIC;
+	param.num_threads = 1;
+	param.percentiles.num = 4;
+	param.percentiles.p[0] = 50;
+	param.percentiles.p[1] = 90;
+	param.percentiles.p[2] = 99;
+	param.percentiles.p[3] = 99.9;
 #ifdef HAVE_SSL
 	param.ssl_reuse = 1;
         param.ssl_verify = 0;
@@ -314,6 +566,8 @@ main(int argc, char **argv)
 				param.additional_header = optarg;
 			else if (flag == &param.additional_header_file)
 				param.additional_header_file = optarg;
+			else if (flag == &param.body_file)
+				param.body_file = optarg;
 			else if (flag == &param.num_calls) {
 				errno = 0;
 				param.num_calls = strtoul(optarg, &end, 10);
@@ -345,6 +599,16 @@ main(int argc, char **argv)
 						prog_name, optarg);
 					exit(1);
 				}
+			} else if (flag == &param.busy_poll) {
+				errno = 0;
+				param.busy_poll = strtod(optarg, &end);
+				if (errno == ERANGE || end == optarg || *end
+				    || param.busy_poll < 0) {
+					fprintf(stderr,
+						"%s: illegal busy-poll window %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
 			} else if (flag == &param.failure_status) {
 				errno = 0;
 				param.failure_status =
@@ -374,6 +638,39 @@ main(int argc, char **argv)
 						prog_name, optarg);
 					exit(1);
 				}
+			} else if (flag == &param.warm_conns) {
+				errno = 0;
+				param.warm_conns = strtoul(optarg, &end, 10);
+				if (errno == ERANGE || end == optarg || *end) {
+					fprintf(stderr,
+						"%s: illegal number of warm connections %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
+			} else if (flag == &param.percentiles) {
+				param.percentiles.num = 0;
+				param.percentiles.given = 1;
+				end = optarg - 1;
+				do {
+					if (param.percentiles.num == MAX_PERCENTILES) {
+						fprintf(stderr,
+							"%s: at most %d percentiles may be given\n",
+							prog_name, MAX_PERCENTILES);
+						exit(1);
+					}
+					cp = end + 1;
+					errno = 0;
+					t = strtod(cp, &end);
+					if (errno == ERANGE || end == cp
+					    || (*end && *end != ',') || t <= 0
+					    || t > 100) {
+						fprintf(stderr,
+							"%s: illegal percentile list %s\n",
+							prog_name, optarg);
+						exit(1);
+					}
+					param.percentiles.p[param.percentiles.num++] = t;
+				} while (*end);
 			} else if (flag == &param.max_piped) {
 				errno = 0;
 				param.max_piped = strtoul(optarg, &end, 10);
@@ -610,6 +907,31 @@ main(int argc, char **argv)
 						prog_name, optarg);
 					exit(1);
 				}
+			} else if (flag == &param.bulk_recv) {
+				errno = 0;
+				param.bulk_recv = strtoul(optarg, &end, 0);
+				if (errno == ERANGE || end == optarg || *end) {
+					fprintf(stderr,
+						"%s: illegal bulk receive buffer size %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
+				/*
+				 * whole pages, as the socket is mapped at this
+				 * size for TCP_ZEROCOPY_RECEIVE 
+				 */
+				page = sysconf(_SC_PAGESIZE);
+				param.bulk_recv = (param.bulk_recv + page - 1)
+				    / page * page;
+			} else if (flag == &param.zerocopy) {
+				errno = 0;
+				param.zerocopy = strtoul(optarg, &end, 0);
+				if (errno == ERANGE || end == optarg || *end) {
+					fprintf(stderr,
+						"%s: illegal zero-copy threshold %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
 			} else if (flag == &param.client) {
 				errno = 0;
 				param.client.id = strtoul(optarg, &end, 0);
@@ -647,6 +969,43 @@ main(int argc, char **argv)
 #ifdef HAVE_SSL
 			else if (flag == &param.ssl_cipher_list)
 				param.ssl_cipher_list = optarg;
+			else if (flag == &param.ssl_threads) {
+				errno = 0;
+				param.ssl_threads = strtoul(optarg, &end, 0);
+				if (errno == ERANGE || end == optarg || *end) {
+					fprintf(stderr,
+						"%s: illegal number of SSL "
+						"threads %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
+#ifndef HAVE_PTHREAD
+				if (param.ssl_threads > 0) {
+					fprintf(stderr,
+						"%s: --ssl-threads needs POSIX "
+						"threads, which this build "
+						"lacks\n", prog_name);
+					exit(1);
+				}
+#endif
+			} else if (flag == &param.ssl_resume) {
+				errno = 0;
+				param.ssl_resume.ratio = strtod(optarg, &end);
+				param.ssl_resume.cache_size = 64;
+				if (*end == ',')
+					param.ssl_resume.cache_size =
+					    strtoul(end + 1, &end, 0);
+				if (errno == ERANGE || end == optarg || *end
+				    || param.ssl_resume.ratio < 0.0
+				    || param.ssl_resume.ratio > 1.0
+				    || param.ssl_resume.cache_size < 1) {
+					fprintf(stderr,
+						"%s: illegal ssl-resume "
+						"parameter %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
+			}
                         else if (flag == &param.ssl_cert)
                                 param.ssl_cert = optarg;
                         else if (flag == &param.ssl_key)
@@ -714,7 +1073,35 @@ main(int argc, char **argv)
 #endif
 			else if (flag == &param.uri)
 				param.uri = optarg;
-			else if (flag == &param.think_timeout) {
+			else if (flag == &param.uri_stats) {
+				errno = 0;
+				param.uri_stats.top = strtoul(optarg, &end, 0);
+				param.uri_stats.max_keys = 1000;
+				if (*end == ',')
+					param.uri_stats.max_keys =
+					    strtoul(end + 1, &end, 0);
+				if (errno == ERANGE || end == optarg || *end
+				    || param.uri_stats.top < 1
+				    || param.uri_stats.max_keys < 1) {
+					fprintf(stderr,
+						"%s: illegal uri-stats "
+						"parameter %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
+			} else if (flag == &param.uri_stats.classes)
+				param.uri_stats.classes = optarg;
+			else if (flag == &param.num_threads) {
+				errno = 0;
+				param.num_threads = strtoul(optarg, &end, 10);
+				if (errno == ERANGE || end == optarg || *end
+				    || param.num_threads < 1) {
+					fprintf(stderr,
+						"%s: illegal number of threads %s\n",
+						prog_name, optarg);
+					exit(1);
+				}
+			} else if (flag == &param.think_timeout) {
 				errno = 0;
 				param.think_timeout = strtod(optarg, &end);
 				if (errno == ERANGE || end == optarg || *end) {
@@ -749,6 +1136,34 @@ main(int argc, char **argv)
 				param.wlog.do_loop = (*optarg == 'y')
 				    || (*optarg == 'Y');
 				param.wlog.file = optarg + 2;
+			} else if (flag == &param.prealloc) {
+				u_long          count[3];
+
+				errno = 0;
+				for (i = 0; i < NELEMS(count); ++i) {
+					count[i] = strtoul(optarg, &end, 0);
+					if (end == optarg || errno == ERANGE
+					    || (*end && *end != ',')) {
+						fprintf(stderr,
+							"%s: illegal prealloc count %s\n",
+							prog_name, optarg);
+						exit(1);
+					}
+					if (!*end)
+						break;
+					optarg = end + 1;
+				}
+				if (i == 0)
+					count[1] = count[2] = count[0];
+				else if (i != NELEMS(count) - 1) {
+					fprintf(stderr, "%s: --prealloc takes "
+						"one or three counts\n",
+						prog_name);
+					exit(1);
+				}
+				param.prealloc.num_conns = count[0];
+				param.prealloc.num_calls = count[1];
+				param.prealloc.num_sessions = count[2];
 			} else if (flag == &param.wsess) {
 				num_gen = 2;	/* XXX fix me---somehow */
 				gen[0] = &wsess;
@@ -1025,6 +1440,8 @@ main(int argc, char **argv)
 		if (param.port < 0)
 			param.port = 443;
 
+		param.zerocopy = 0;	/* not with (kernel) TLS */
+
                 SSL_library_init ();
 		SSL_load_error_strings ();
 #if (OPENSSL_VERSION_NUMBER < 0x10100000L)
@@ -1129,6 +1546,28 @@ main(int argc, char **argv)
                 else
                     SSL_CTX_set_verify (ssl_ctx, SSL_VERIFY_NONE, NULL);
 
+                /* let the kernel do record processing after the handshake */
+                if (param.ssl_ktls)
+                {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+                    SSL_CTX_set_options (ssl_ctx, SSL_OP_ENABLE_KTLS);
+#else
+                    fprintf (stderr, "%s: warning: OpenSSL lacks kernel TLS "
+                             "support; ignoring --ssl-ktls\n", prog_name);
+                    param.ssl_ktls = 0;
+#endif
+                }
+
+                /* keep the sessions servers hand out for resumption */
+                if (param.ssl_resume.cache_size > 0)
+                    ssl_cache_init (ssl_ctx);
+                if (param.ssl_early_data && !param.ssl_resume.cache_size)
+                {
+                    fprintf (stderr, "%s: --ssl-early-data requires "
+                             "--ssl-resume\n", prog_name);
+                    exit (1);
+                }
+
                 /* set default certificate authority verification path */
                 SSL_CTX_set_default_verify_paths (ssl_ctx);
 
@@ -1176,7 +1615,8 @@ main(int argc, char **argv)
                         exit (1);
                     }
                 }      
-	}
+	} else
+		param.ssl_early_data = 0;
 #endif
 	if (param.port < 0)
 		param.port = 80;
@@ -1184,6 +1624,16 @@ main(int argc, char **argv)
 	if (param.print_reply || param.print_request)
 		stat[num_stats++] = &stats_print_reply;
 
+	if (param.phase_stats)
+		stat[num_stats++] = &phase_stat;
+
+	if (param.uri_stats.classes && !param.uri_stats.top) {
+		param.uri_stats.top = 10;
+		param.uri_stats.max_keys = 1000;
+	}
+	if (param.uri_stats.top)
+		stat[num_stats++] = &uri_stat;
+
 	if (param.session_cookies) {
 		if (!session_workload) {
 			fprintf(stderr,
@@ -1195,7 +1645,7 @@ main(int argc, char **argv)
 	}
 
 	if (param.additional_header || param.additional_header_file ||
-	    param.method)
+	    param.body_file || param.method)
 		gen[num_gen++] = &misc;
 
 	/*
@@ -1234,12 +1684,22 @@ main(int argc, char **argv)
 		printf(" --hog");
 	if (param.close_with_reset)
 		printf(" --close-with-reset");
+	if (param.edge_triggered)
+		printf(" --edge-triggered");
+	if (param.hugepages)
+		printf(" --hugepages");
+	if (param.prealloc.num_conns || param.prealloc.num_calls
+	    || param.prealloc.num_sessions)
+		printf(" --prealloc=%lu,%lu,%lu", param.prealloc.num_conns,
+		       param.prealloc.num_calls, param.prealloc.num_sessions);
 	if (param.think_timeout > 0)
 		printf(" --think-timeout=%g", param.think_timeout);
 	if (param.timeout > 0)
 		printf(" --timeout=%g", param.timeout);
 	if (param.runtime > 0)
 		printf(" --runtime=%g", param.runtime);
+	if (param.busy_poll > 0)
+		printf(" --busy-poll=%g", param.busy_poll);
 	printf(" --client=%u/%u", param.client.id, param.client.num_clients);
 	if (param.server)
 		printf(" --server=%s", param.server);
@@ -1260,6 +1720,12 @@ main(int argc, char **argv)
 		printf(" --max-connections=%lu", param.max_conns);
 	if (param.max_piped)
 		printf(" --max-piped-calls=%lu", param.max_piped);
+	if (param.percentiles.given) {
+		printf(" --percentiles=");
+		for (i = 0; i < (int) param.percentiles.num; ++i)
+			printf("%s%g", i ? "," : "",
+			       param.percentiles.p[i]);
+	}
 	if (param.rate.rate_param > 0.0) {
 		switch (param.rate.dist) {
 		case DETERMINISTIC:
@@ -1301,6 +1767,10 @@ main(int argc, char **argv)
 	if (param.retry_on_failure)
 		printf(" --retry-on-failure");
 	printf(" --recv-buffer=%lu", param.recv_buffer_size);
+	if (param.bulk_recv > 0)
+		printf(" --bulk-recv=%lu", param.bulk_recv);
+	if (param.zerocopy > 0)
+		printf(" --zerocopy=%lu", param.zerocopy);
 	if (param.session_cookies)
 		printf(" --session-cookies");
 #ifdef HAVE_SSL
@@ -1312,6 +1782,15 @@ main(int argc, char **argv)
 		printf(" --tls-server-name=%s", param.tls_server_name);
 	if (!param.ssl_reuse)
 		printf(" --ssl-no-reuse");
+	if (param.ssl_ktls)
+		printf(" --ssl-ktls");
+	if (param.ssl_resume.cache_size > 0)
+		printf(" --ssl-resume=%g,%u", param.ssl_resume.ratio,
+		       param.ssl_resume.cache_size);
+	if (param.ssl_early_data)
+		printf(" --ssl-early-data");
+	if (param.ssl_threads > 0)
+		printf(" --ssl-threads=%u", param.ssl_threads);
         if (param.ssl_cert) printf (" --ssl-cert=%s", param.ssl_cert);
         if (param.ssl_key) printf (" --ssl-key=%s", param.ssl_key);
         if (param.ssl_ca_file) printf (" --ssl-ca-file=%s", param.ssl_ca_file);
@@ -1338,10 +1817,18 @@ main(int argc, char **argv)
 		printf(" --add-header='%s'", param.additional_header);
 	if (param.additional_header_file)
 		printf(" --add-header-file='%s'", param.additional_header_file);
+	if (param.body_file)
+		printf(" --body-file='%s'", param.body_file);
 	if (param.method)
 		printf(" --method=%s", param.method);
+	if (param.tfo)
+		printf(" --tfo");
 	if (param.use_timer_cache)
 		printf(" --use-timer-cache");
+	if (param.num_threads > 1)
+		printf(" --threads=%u", param.num_threads);
+	if (param.warm_conns)
+		printf(" --warm-conns=%lu", param.warm_conns);
 	if (param.wsesslog.num_sessions) {
 		/*
 		 * This overrides any --wsess, --num-conns, --num-calls,
@@ -1369,6 +1856,13 @@ main(int argc, char **argv)
 			       param.wset.num_files,
 			       param.wset.target_miss_rate);
 	}
+	if (param.phase_stats)
+		printf(" --phase-stats");
+	if (param.uri_stats.top)
+		printf(" --uri-stats=%u,%u", param.uri_stats.top,
+		       param.uri_stats.max_keys);
+	if (param.uri_stats.classes)
+		printf(" --uri-class=%s", param.uri_stats.classes);
 	if (periodic_stats)
 		printf(" --periodic-stats");
 	printf("\n");
@@ -1379,21 +1873,54 @@ main(int argc, char **argv)
 			prog_name, __LINE__);
 		exit(1);
 	}
-	core_init();
 
-	signal(SIGINT, (void (*)()) core_exit);
+	if (param.num_threads > 1 && spawn_workers()) {
+		signal(SIGINT, stop_workers);
+
+		for (i = 0; i < num_stats; ++i)
+			(*stat[i]->init) ();
+		collect_workers(stat, num_stats);
+		for (i = 0; i < num_stats; ++i)
+			(*stat[i]->dump) ();
+
+		timer_free_all();
+		return 0;
+	}
 
+	/*
+	 * The collectors come first so that they see the hostname lookups
+	 * done by core_init(). 
+	 */
 	for (i = 0; i < num_stats; ++i)
 		(*stat[i]->init) ();
+
+	core_init();
+
+	signal(SIGINT, (void (*)()) core_exit);
+
 	for (i = 0; i < num_gen; ++i)
 		(*gen[i]->init) ();
 
+	/*
+	 * Object sizes are final only now that the generators have
+	 * reserved their private areas. 
+	 */
+	object_prealloc(OBJ_CONN, param.prealloc.num_conns);
+	object_prealloc(OBJ_CALL, param.prealloc.num_calls);
+	object_prealloc(OBJ_SESS, param.prealloc.num_sessions);
+
 	/*
 	 * Update `now'.  This is to keep things accurate even when some of
 	 * the initialization routines take a long time to execute.  
 	 */
 	timer_now_forced();
 
+	/*
+	 * Established connections are part of the setup, not the test.
+	 */
+	if (param.warm_conns > 0)
+		core_warm_up();
+
 	/*
 	 * ensure that clients sample rates at different times: 
 	 */
@@ -1417,8 +1944,22 @@ main(int argc, char **argv)
 		(*stat[i]->stop) ();
 	for (i = 0; i < num_gen; ++i)
 		(*gen[i]->stop) ();
-	for (i = 0; i < num_stats; ++i)
-		(*stat[i]->dump) ();
+
+	if (worker_fd >= 0) {
+		Worker_Report   report;
+
+		report.time_start = test_time_start;
+		report.time_stop = test_time_stop;
+		report.rusage_start = test_rusage_start;
+		report.rusage_stop = test_rusage_stop;
+		write_fully(worker_fd, &report, sizeof(report));
+		for (i = 0; i < num_stats; ++i)
+			if (stat[i]->save)
+				(*stat[i]->save) (worker_fd);
+		close(worker_fd);
+	} else
+		for (i = 0; i < num_stats; ++i)
+			(*stat[i]->dump) ();
 
 	timer_free_all();
 
@@ -40,6 +40,7 @@
 #define TV_TO_SEC(tv)	((tv).tv_sec + 1e-6*(tv).tv_usec)
 
 #define NUM_RATES 16
+#define MAX_PERCENTILES 16
 
 typedef enum Dist_Type
   {
@@ -69,6 +70,11 @@ typedef struct Stat_Collector
     void (*start) (void);
     void (*stop) (void);
     void (*dump) (void);
+    /* SAVE and MERGE are optional.  With --threads, each worker SAVEs
+       its state to a pipe and the parent MERGEs every worker's state
+       into its own before calling DUMP.  */
+    void (*save) (int fd);
+    void (*merge) (int fd);
   }
 Stat_Collector;
 
@@ -101,26 +107,43 @@ typedef struct Cmdline_Params
     Time timeout;	/* watchdog timeout */
     Time think_timeout;	/* timeout for server think time */
     Time runtime;	/* how long to run the test */
+    Time busy_poll;	/* poll instead of sleeping this close to a timer */
     u_long num_conns;	/* # of connections to generate */
     u_long num_calls;	/* # of calls to generate per connection */
     u_long burst_len;	/* # of calls to burst back-to-back */
     u_long max_piped;	/* max # of piped calls per connection */
     u_long max_conns;	/* max # of connections per session */
+    u_long warm_conns;	/* # of connections per server set up in advance */
     int hog;		/* client may hog as much resources as possible */
     u_long send_buffer_size;
     u_long recv_buffer_size;
+    u_long bulk_recv;	/* per-connection receive buffer size (0 = off) */
+    u_long zerocopy;	/* MSG_ZEROCOPY bodies of this many bytes (0 = never) */
     int failure_status;	/* status code that should be considered failure */
     int retry_on_failure; /* when a call fails, should we retry? */
     int close_with_reset; /* close connections with TCP RESET? */
+    int tfo;		/* send the first request in the SYN? */
+    int edge_triggered;	/* use edge-triggered event notification? */
+    int hugepages;	/* back object pools with huge pages? */
     int print_request;	/* bit 0: print req headers, bit 1: print req body */
     int print_reply;	/* bit 0: print repl headers, bit 1: print repl body */
     int session_cookies; /* handle set-cookies? (at the session level) */
     int no_host_hdr;	/* don't send Host: header in request */
+    int phase_stats;	/* break latencies down by phase? */
 #ifdef HAVE_SSL
     int use_ssl;	/* connect via SSL */
     int ssl_reuse;	/* reuse SSL Session ID */
     int ssl_verify;     /* whether to verify the server certificate */
     int ssl_protocol;   /* which SSL protocol to use */
+    int ssl_ktls;	/* offload record processing to kernel TLS? */
+    struct
+      {
+	double ratio;	/* fraction of handshakes that try to resume */
+	u_int cache_size;	/* sessions kept per server (0 = store off) */
+      }
+    ssl_resume;
+    int ssl_early_data;	/* send first request as TLS 1.3 early data? */
+    u_int ssl_threads;	/* # of threads doing TLS handshakes (0 = inline) */
     const char *tls_server_name; /* TLS SNI (server name indication) */
     const char *ssl_cipher_list; /* client's list of SSL cipher suites */
     const char *ssl_cert; /* client certificate file name */
@@ -129,8 +152,10 @@ typedef struct Cmdline_Params
     const char *ssl_ca_path; /* certificate authority path */
 #endif
     int use_timer_cache;
+    u_int num_threads;	/* # of independent event loops */
     const char *additional_header;	/* additional request header(s) */
     const char *additional_header_file;
+    const char *body_file;	/* file sent as the body of every request */
     const char *method;	/* default call method */
     struct
       {
@@ -171,6 +196,27 @@ typedef struct Cmdline_Params
 	double target_miss_rate;
       }
     wset;
+    struct
+      {
+	u_long num_conns;	/* # of connections to allocate up front */
+	u_long num_calls;	/* # of calls to allocate up front */
+	u_long num_sessions;	/* # of sessions to allocate up front */
+      }
+    prealloc;
+    struct
+      {
+	u_int num;		/* # of percentiles to report */
+	double p[MAX_PERCENTILES];
+	int given;		/* set by --percentiles (else defaults) */
+      }
+    percentiles;
+    struct
+      {
+	u_int top;		/* # of keys to report (0 = don't collect) */
+	u_int max_keys;		/* # of keys kept apart from "other" */
+	const char *classes;	/* comma-separated URI prefixes */
+      }
+    uri_stats;
   }
 Cmdline_Params;
 
@@ -197,5 +243,7 @@ extern struct rusage test_rusage_stop;
 
 extern void panic (const char *msg, ...);
 extern void no_op (void);
+extern void write_fully (int fd, const void *buf, size_t len);
+extern int read_fully (int fd, void *buf, size_t len);
 
 #endif /* httperf_h */
@@ -0,0 +1,197 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+#include "config.h"
+
+#include <string.h>
+
+#include <generic_types.h>
+#include <histogram.h>
+
+#define HIST_MAX_VALUE	((((u_wide) 1) << HIST_MAX_BITS) - 1)
+
+/*
+ * Position of the most significant bit set in V (which is not 0).
+ */
+static int
+msb(u_wide v)
+{
+#ifdef __GNUC__
+	return 8 * sizeof(unsigned long long) - 1 - __builtin_clzll(v);
+#else
+	int             n = 0;
+
+	while (v >>= 1)
+		++n;
+	return n;
+#endif
+}
+
+/*
+ * Values below 2^SUB_BITS have a counter each.  Above that, the values
+ * between 2^k and 2^(k+1) share 2^(SUB_BITS-1) counters, each covering
+ * 2^shift values, where shift = k - SUB_BITS + 1.
+ */
+static u_int
+bucket(u_wide v, int sub_bits)
+{
+	int             shift;
+
+	if (v < ((u_wide) 1 << sub_bits))
+		return v;
+	shift = msb(v) - (sub_bits - 1);
+	return (shift << (sub_bits - 1)) + (v >> shift);
+}
+
+/*
+ * The largest value that falls into bucket I.
+ */
+static u_wide
+bucket_top(u_int i, int sub_bits)
+{
+	int             shift;
+
+	if (i < (1u << sub_bits))
+		return i;
+	shift = (i >> (sub_bits - 1)) - 1;
+	return ((u_wide) (i - (shift << (sub_bits - 1)) + 1) << shift) - 1;
+}
+
+void
+histogram_init(Histogram * h)
+{
+	memset(h, 0, sizeof(*h));
+	h->min = HIST_MAX_VALUE;
+}
+
+void
+histogram_record(Histogram * h, u_wide v)
+{
+	if (v > HIST_MAX_VALUE)
+		v = HIST_MAX_VALUE;
+	++h->counts[bucket(v, HIST_SUB_BITS)];
+	++h->total;
+	if (v < h->min)
+		h->min = v;
+	if (v > h->max)
+		h->max = v;
+}
+
+void
+histogram_merge(Histogram * dst, const Histogram * src)
+{
+	u_int           i;
+
+	for (i = 0; i < HIST_NUM_COUNTS; ++i)
+		dst->counts[i] += src->counts[i];
+	dst->total += src->total;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+/*
+ * Returns the value that P percent of the recorded values do not
+ * exceed, rounded up to the end of its bucket (but never beyond the
+ * largest value actually recorded).
+ */
+u_wide
+histogram_percentile(const Histogram * h, double p)
+{
+	u_wide          rank, n = 0;
+	u_int           i;
+
+	if (h->total == 0)
+		return 0;
+	rank = (u_wide) (p / 100.0 * h->total + 0.5);
+	if (rank < 1)
+		rank = 1;
+	for (i = 0; i < HIST_NUM_COUNTS; ++i) {
+		n += h->counts[i];
+		if (n >= rank)
+			return bucket_top(i, HIST_SUB_BITS) < h->max
+			    ? bucket_top(i, HIST_SUB_BITS) : h->max;
+	}
+	return h->max;
+}
+
+void
+compact_histogram_init(Compact_Histogram * h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+void
+compact_histogram_record(Compact_Histogram * h, u_wide v)
+{
+	if (v > HIST_MAX_VALUE)
+		v = HIST_MAX_VALUE;
+	++h->counts[bucket(v, CHIST_SUB_BITS)];
+	++h->total;
+	if (v > h->max)
+		h->max = v;
+}
+
+void
+compact_histogram_merge(Compact_Histogram * dst,
+			const Compact_Histogram * src)
+{
+	u_int           i;
+
+	for (i = 0; i < CHIST_NUM_COUNTS; ++i)
+		dst->counts[i] += src->counts[i];
+	dst->total += src->total;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+u_wide
+compact_histogram_percentile(const Compact_Histogram * h, double p)
+{
+	u_wide          rank, n = 0;
+	u_int           i;
+
+	if (h->total == 0)
+		return 0;
+	rank = (u_wide) (p / 100.0 * h->total + 0.5);
+	if (rank < 1)
+		rank = 1;
+	for (i = 0; i < CHIST_NUM_COUNTS; ++i) {
+		n += h->counts[i];
+		if (n >= rank)
+			return bucket_top(i, CHIST_SUB_BITS) < h->max
+			    ? bucket_top(i, CHIST_SUB_BITS) : h->max;
+	}
+	return h->max;
+}
@@ -0,0 +1,83 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+#ifndef histogram_h
+#define histogram_h
+
+/*
+ * A log-linear histogram in the manner of HdrHistogram: values below
+ * 2^HIST_SUB_BITS are counted exactly, larger ones in buckets whose
+ * width doubles with every power of two, so that a value is never off
+ * by more than 1/2^(HIST_SUB_BITS-1) of itself.  Recording is a few
+ * shifts; the memory is fixed, so a histogram can be embedded in a
+ * structure and copied around as a whole.
+ */
+#define HIST_SUB_BITS	7	/* buckets at most 1/64 of their values */
+#define HIST_MAX_BITS	36	/* values up to 2^36 - 1 */
+#define HIST_HALF	(1 << (HIST_SUB_BITS - 1))
+#define HIST_NUM_COUNTS	((HIST_MAX_BITS - HIST_SUB_BITS + 2) * HIST_HALF)
+
+typedef struct Histogram {
+	u_wide          total;	/* # of values recorded */
+	u_wide          min;
+	u_wide          max;
+	u_wide          counts[HIST_NUM_COUNTS];
+} Histogram;
+
+/*
+ * The same over the same range, but with buckets up to 1/16 of their
+ * values and 32-bit counters, for when there are many histograms.
+ */
+#define CHIST_SUB_BITS	5
+#define CHIST_HALF	(1 << (CHIST_SUB_BITS - 1))
+#define CHIST_NUM_COUNTS ((HIST_MAX_BITS - CHIST_SUB_BITS + 2) * CHIST_HALF)
+
+typedef struct Compact_Histogram {
+	u_int           total;	/* # of values recorded */
+	u_wide          max;
+	u_int           counts[CHIST_NUM_COUNTS];
+} Compact_Histogram;
+
+void            histogram_init(Histogram *);
+void            histogram_record(Histogram *, u_wide);
+void            histogram_merge(Histogram *, const Histogram *);
+u_wide          histogram_percentile(const Histogram *, double);
+
+void            compact_histogram_init(Compact_Histogram *);
+void            compact_histogram_record(Compact_Histogram *, u_wide);
+void            compact_histogram_merge(Compact_Histogram *,
+					const Compact_Histogram *);
+u_wide          compact_histogram_percentile(const Compact_Histogram *,
+					     double);
+
+#endif /* histogram_h */
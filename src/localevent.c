@@ -105,6 +105,12 @@ event_register_handler (Event_Type et, Event_Handler handler, Any_Type arg)
   action[et].num_ops = n + 1;
 }
 
+int
+event_has_handler (Event_Type type)
+{
+  return action[type].num_ops > 0;
+}
+
 void
 event_signal (Event_Type type, Object *obj, Any_Type arg)
 {
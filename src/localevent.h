@@ -87,4 +87,8 @@ extern void event_register_handler (Event_Type et, Event_Handler handler,
 				    Any_Type arg);
 extern void event_signal (Event_Type type, Object *obj, Any_Type arg);
 
+/* Return non-zero if any handler is registered for events of type
+   TYPE.  */
+extern int event_has_handler (Event_Type type);
+
 #endif /* localevent_h */
@@ -38,6 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include <generic_types.h>
 
@@ -58,6 +59,12 @@ static size_t type_size[OBJ_NUM_TYPES] =
     ALIGN (sizeof (Sess))
   };
 
+/* Objects are carved out of large chunks ("slabs") that are never
+   returned to the system, so that a run stops calling malloc() once the
+   pools have reached their working size.  */
+#define SLAB_SIZE	(256*1024)
+#define HUGE_PAGE_SIZE	(2*1024*1024)
+
 struct free_list_el
   {
     struct free_list_el *next;
@@ -65,6 +72,71 @@ struct free_list_el
 
 static struct free_list_el *free_list[OBJ_NUM_TYPES];
 
+static struct slab
+  {
+    char *next;			/* next unused byte in current chunk */
+    char *end;			/* end of current chunk */
+    u_long in_use;		/* # of live objects */
+    u_long max_in_use;		/* high-water mark of in_use */
+    u_long allocated;		/* # of objects carved so far */
+  }
+slab[OBJ_NUM_TYPES];
+
+/* Allocate a chunk of at least *SIZEP bytes.  Huge pages come in
+   whole units, so *SIZEP is updated to the size actually mapped.  */
+static void *
+slab_chunk_alloc (size_t *sizep)
+{
+  static int hugepages_failed;
+  size_t size = *sizep;
+  void *chunk;
+
+#ifdef MAP_HUGETLB
+  if (param.hugepages && !hugepages_failed)
+    {
+      size = (size + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1);
+      chunk = mmap (0, size, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (chunk != MAP_FAILED)
+	{
+	  *sizep = size;
+	  return chunk;
+	}
+      fprintf (stderr, "%s: failed to map huge pages (%s); "
+	       "using regular pages\n", prog_name, strerror (errno));
+      hugepages_failed = 1;
+    }
+#endif
+  chunk = malloc (size);
+  if (!chunk)
+    fprintf (stderr, "%s.object_new: %s\n", prog_name, strerror (errno));
+  return chunk;
+}
+
+/* Make sure the current chunk for TYPE has room for COUNT more objects.
+   Returns zero if memory ran out.  */
+static int
+slab_reserve (Object_Type type, u_long count)
+{
+  struct slab *s = &slab[type];
+  size_t size;
+
+  if ((size_t) (s->end - s->next) >= count * type_size[type])
+    return 1;
+
+  size = count * type_size[type];
+  if (size < SLAB_SIZE)
+    size = SLAB_SIZE;
+  s->next = slab_chunk_alloc (&size);
+  if (!s->next)
+    {
+      s->end = 0;
+      return 0;
+    }
+  s->end = s->next + size;
+  return 1;
+}
+
 static void
 object_destroy (Object *obj)
 {
@@ -98,11 +170,12 @@ object_destroy (Object *obj)
   event_signal (event, obj, arg);
 
   /* Each object must be at least the size and alignment of "struct
-     free_list_el".  Malloc takes care of returning properly aligned
-     objects.  */
+     free_list_el".  Slab chunks come from malloc() or mmap() and object
+     sizes are rounded up by ALIGN(), so this holds for every object.  */
   el = (struct free_list_el *) obj;
   el->next = free_list[type];
   free_list[type] = el;
+  --slab[type].in_use;
 }
 
 size_t
@@ -132,13 +205,14 @@ object_new (Object_Type type)
     }
   else
     {
-      obj = malloc (obj_size);
-      if (!obj)
-	{
-	  fprintf (stderr, "%s.object_new: %s\n", prog_name, strerror (errno));
-	  return 0;
-	}
+      if (!slab_reserve (type, 1))
+	return 0;
+      obj = (Object *) slab[type].next;
+      slab[type].next += obj_size;
+      ++slab[type].allocated;
     }
+  if (++slab[type].in_use > slab[type].max_in_use)
+    slab[type].max_in_use = slab[type].in_use;
   memset (obj, 0, obj_size);
   obj->ref_count = 1;
   obj->type = type;
@@ -168,6 +242,28 @@ object_new (Object_Type type)
   return obj;
 }
 
+void
+object_prealloc (Object_Type type, u_long count)
+{
+  struct slab *s = &slab[type];
+
+  if (count == 0)
+    return;
+  if (!slab_reserve (type, count))
+    exit (1);
+
+  /* Touch the memory now so the page faults don't happen during the
+     measurement.  */
+  memset (s->next, 0, s->end - s->next);
+}
+
+void
+object_stats (Object_Type type, u_long *max_in_use, u_long *allocated)
+{
+  *max_in_use = slab[type].max_in_use;
+  *allocated = slab[type].allocated;
+}
+
 void
 object_dec_ref (Object *obj)
 {
@@ -68,6 +68,15 @@ extern size_t object_expand (Object_Type type, size_t size);
 /* Create a new object of type TYPE.  */
 extern Object *object_new (Object_Type type);
 
+/* Allocate (and fault in) memory for COUNT objects of type TYPE ahead
+   of time.  Must be called after the last object_expand().  */
+extern void object_prealloc (Object_Type type, u_long count);
+
+/* Return the largest number of objects of type TYPE that were alive at
+   the same time and the number of objects that had to be allocated.  */
+extern void object_stats (Object_Type type, u_long *max_in_use,
+			  u_long *allocated);
+
 /* Create a new reference for object OBJ.  */
 #define object_inc_ref(o)	(++(o)->ref_count)
 
@@ -0,0 +1,207 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+/* Client-side TLS session store.  OpenSSL's own client cache is
+   turned off; instead, every session the server hands out is kept
+   in a small per-server ring (a server being a hostname/port pair),
+   so that resumption is not tied to a particular connection or
+   session of the workload generator.  TLS 1.3 tickets are meant to
+   be used only once, so they are removed from the ring when offered;
+   TLS 1.2 sessions stay until pushed out by newer ones.  */
+
+#include "config.h"
+
+#ifdef HAVE_SSL
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+#include <generic_types.h>
+#include <object.h>
+#include <timer.h>
+#include <httperf.h>
+#include <conn.h>
+#include <ssl_cache.h>
+
+#if (OPENSSL_VERSION_NUMBER < 0x10101000L)
+# define SSL_SESSION_is_resumable(s)	1
+#endif
+
+typedef struct Server_Sessions
+  {
+    struct Server_Sessions *next;
+    const char *hostname;
+    size_t hostname_len;
+    int port;
+    u_int first;		/* oldest session in the ring */
+    u_int count;		/* # of sessions in the ring */
+    SSL_SESSION *sess[1];	/* really param.ssl_resume.cache_size */
+  }
+Server_Sessions;
+
+static Server_Sessions *servers;
+static double resume_credit;
+
+#ifdef HAVE_PTHREAD
+/* With --ssl-threads, TLS 1.2 sessions arrive on handshake workers: */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+# define LOCK()		pthread_mutex_lock (&lock)
+# define UNLOCK()	pthread_mutex_unlock (&lock)
+#else
+# define LOCK()
+# define UNLOCK()
+#endif
+
+static Server_Sessions *
+lookup (Conn *conn)
+{
+  Server_Sessions *s, **prev;
+
+  for (prev = &servers; (s = *prev); prev = &s->next)
+    if (s->port == conn->port && s->hostname_len == conn->hostname_len
+	&& memcmp (s->hostname, conn->hostname, s->hostname_len) == 0)
+      {
+	if (prev != &servers)
+	  {
+	    /* move to front: */
+	    *prev = s->next;
+	    s->next = servers;
+	    servers = s;
+	  }
+	return s;
+      }
+
+  s = malloc (sizeof (*s) + (param.ssl_resume.cache_size - 1)
+	      * sizeof (s->sess[0]));
+  if (!s)
+    {
+      fprintf (stderr, "%s.ssl_cache: %s\n", prog_name, strerror (errno));
+      exit (1);
+    }
+  s->hostname = conn->hostname;
+  s->hostname_len = conn->hostname_len;
+  s->port = conn->port;
+  s->first = s->count = 0;
+  s->next = servers;
+  servers = s;
+  return s;
+}
+
+static int
+new_session (SSL *ssl, SSL_SESSION *sess)
+{
+  Server_Sessions *s;
+  Conn *conn;
+  u_int size = param.ssl_resume.cache_size;
+
+  conn = SSL_get_app_data (ssl);
+  if (!conn || !SSL_SESSION_is_resumable (sess))
+    return 0;
+
+  LOCK ();
+  s = lookup (conn);
+  if (s->count == size)
+    {
+      SSL_SESSION_free (s->sess[s->first]);
+      s->first = (s->first + 1) % size;
+      --s->count;
+    }
+  s->sess[(s->first + s->count++) % size] = sess;
+
+  if (DBG > 1)
+    fprintf (stderr, "ssl_cache: stored session %p for %s:%d (%u cached)\n",
+	     (void *) sess, conn->hostname, conn->port, s->count);
+  UNLOCK ();
+  return 1;			/* we keep the reference */
+}
+
+void
+ssl_cache_init (SSL_CTX *ctx)
+{
+  SSL_CTX_set_session_cache_mode (ctx, SSL_SESS_CACHE_CLIENT
+				  | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb (ctx, new_session);
+}
+
+int
+ssl_cache_offer (Conn *conn)
+{
+  SSL_SESSION *sess;
+  Server_Sessions *s;
+  u_int size = param.ssl_resume.cache_size;
+  u_int i;
+
+  /* Spread resumptions evenly, so that any window of the test sees
+     the requested mix of full and abbreviated handshakes: */
+  resume_credit += param.ssl_resume.ratio;
+  if (resume_credit < 1.0)
+    return 0;
+
+  LOCK ();
+  s = lookup (conn);
+  while (s->count > 0)
+    {
+      /* offer the newest session: */
+      i = (s->first + s->count - 1) % size;
+      sess = s->sess[i];
+      if (!SSL_SESSION_is_resumable (sess))
+	{
+	  SSL_SESSION_free (sess);
+	  --s->count;
+	  continue;
+	}
+      SSL_set_session (conn->ssl, sess);
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+      if (SSL_SESSION_get_protocol_version (sess) == TLS1_3_VERSION)
+	{
+	  SSL_SESSION_free (sess);	/* tickets are single-use */
+	  --s->count;
+	}
+#endif
+      UNLOCK ();
+      resume_credit -= 1.0;
+      return 1;
+    }
+  UNLOCK ();
+  /* Nothing to offer yet; try again with the next connection rather
+     than saving up for a burst of resumptions later on: */
+  resume_credit = 1.0;
+  return 0;
+}
+
+#endif /* HAVE_SSL */
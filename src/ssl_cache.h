@@ -0,0 +1,51 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+#ifndef ssl_cache_h
+#define ssl_cache_h
+
+#ifdef HAVE_SSL
+
+/* Set up the shared resumption store: sessions (TLS 1.3 tickets or
+   TLS 1.2 session ids) that servers hand out are kept per server
+   and offered to later connections to the same server.  */
+extern void ssl_cache_init (SSL_CTX *ctx);
+
+/* Decide whether CONN's handshake should try to resume and, if so,
+   hand it a cached session for its server.  Must be called before
+   the handshake starts.  Returns non-zero if a session was offered.  */
+extern int ssl_cache_offer (Conn *conn);
+
+#endif /* HAVE_SSL */
+
+#endif /* ssl_cache_h */
@@ -0,0 +1,164 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+/* A small pool of threads that runs the CPU-heavy steps of TLS
+   handshakes (key exchange, signature checks) off the event loop.
+   Jobs go in and come back out on two queues linked through the
+   connections themselves.  The event loop learns about finished jobs
+   through a pipe that a worker writes to whenever the done queue
+   turns non-empty.  */
+
+#include "config.h"
+
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <generic_types.h>
+#include <object.h>
+#include <timer.h>
+#include <httperf.h>
+#include <conn.h>
+#include <ssl_pool.h>
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static Conn *todo, *todo_tail;	/* jobs waiting for a worker */
+static Conn *done, *done_tail;	/* jobs waiting to be collected */
+static int (*job_fn) (Conn *conn);
+static int wake_fd[2];
+
+static void *
+worker (void *arg)
+{
+  Conn *conn;
+  int was_empty;
+
+  for (;;)
+    {
+      pthread_mutex_lock (&lock);
+      while (!todo)
+	pthread_cond_wait (&work, &lock);
+      conn = todo;
+      todo = conn->ssl_job_next;
+      pthread_mutex_unlock (&lock);
+
+      conn->ssl_job_result = (*job_fn) (conn);
+
+      pthread_mutex_lock (&lock);
+      conn->ssl_job_next = 0;
+      was_empty = !done;
+      if (done)
+	done_tail->ssl_job_next = conn;
+      else
+	done = conn;
+      done_tail = conn;
+      pthread_mutex_unlock (&lock);
+
+      if (was_empty)
+	while (write (wake_fd[1], "", 1) < 0 && errno == EINTR)
+	  ;
+    }
+  return 0;
+}
+
+int
+ssl_pool_init (u_int num_threads, int (*fn) (Conn *conn))
+{
+  pthread_t tid;
+  u_int i;
+  int err;
+
+  job_fn = fn;
+  if (pipe (wake_fd) < 0)
+    {
+      fprintf (stderr, "%s.ssl_pool_init: pipe() failed: %s\n",
+	       prog_name, strerror (errno));
+      exit (1);
+    }
+  fcntl (wake_fd[0], F_SETFL, O_NONBLOCK);
+  fcntl (wake_fd[1], F_SETFL, O_NONBLOCK);
+
+  for (i = 0; i < num_threads; ++i)
+    {
+      err = pthread_create (&tid, 0, worker, 0);
+      if (err)
+	{
+	  fprintf (stderr, "%s.ssl_pool_init: pthread_create() failed: %s\n",
+		   prog_name, strerror (err));
+	  exit (1);
+	}
+      pthread_detach (tid);
+    }
+  return wake_fd[0];
+}
+
+void
+ssl_pool_submit (Conn *conn)
+{
+  conn->ssl_job_next = 0;
+  pthread_mutex_lock (&lock);
+  if (todo)
+    todo_tail->ssl_job_next = conn;
+  else
+    todo = conn;
+  todo_tail = conn;
+  pthread_cond_signal (&work);
+  pthread_mutex_unlock (&lock);
+}
+
+Conn *
+ssl_pool_collect (void)
+{
+  char buf[64];
+  Conn *list;
+
+  /* Drain the pipe first: a job finishing after this point either
+     makes it onto the list taken below or writes a fresh byte.  */
+  while (read (wake_fd[0], buf, sizeof (buf)) > 0)
+    ;
+
+  pthread_mutex_lock (&lock);
+  list = done;
+  done = 0;
+  pthread_mutex_unlock (&lock);
+  return list;
+}
+
+#endif /* HAVE_SSL && HAVE_PTHREAD */
@@ -0,0 +1,54 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+#ifndef ssl_pool_h
+#define ssl_pool_h
+
+#if defined(HAVE_SSL) && defined(HAVE_PTHREAD)
+
+/* Start NUM_THREADS threads that run FN on the connections handed to
+   ssl_pool_submit().  Returns a descriptor that becomes readable
+   whenever finished jobs are waiting to be collected.  */
+extern int ssl_pool_init (u_int num_threads, int (*fn) (Conn *conn));
+
+/* Have a worker run FN on CONN.  The caller must leave CONN's SSL
+   object and socket alone until the job has been collected.  */
+extern void ssl_pool_submit (Conn *conn);
+
+/* Return the list (linked through ssl_job_next) of connections whose
+   job has finished, FN's result being in ssl_job_result, or NULL.  */
+extern Conn *ssl_pool_collect (void);
+
+#endif /* HAVE_SSL && HAVE_PTHREAD */
+
+#endif /* ssl_pool_h */
@@ -39,8 +39,11 @@
 #include <errno.h>
 #include <float.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <generic_types.h>
+#include <histogram.h>
 #include <sys/resource.h>
 
 #include <object.h>
@@ -48,19 +51,14 @@
 #include <httperf.h>
 #include <call.h>
 #include <conn.h>
+#include <core.h>
 #include <localevent.h>
 #include <stats.h>
 
-/*
- * Increase this if it does not cover at least 50% of all response times.  
- */
-#define MAX_LIFETIME	100.0	/* max. conn. lifetime in seconds */
-#define BIN_WIDTH	1e-3
-#define NUM_BINS	((u_int) (MAX_LIFETIME / BIN_WIDTH))
-
-static struct {
+static struct Basic_Stats {
 	u_long           num_conns_issued;	/* total # of connections * issued */
-	u_long           num_replies[6];	/* completion count per status class */
+	u_long           num_replies[6];	/* completion count per status class
+					 * (0 = invalid status line) */
 	u_long           num_200;		/* total # of 200 responses */
 	u_long           num_302;		/* total # of 302 responses */
 	u_long           num_client_timeouts;	/* # of client timeouts */
@@ -73,6 +71,9 @@ static struct {
 	u_long           num_sock_addrunavail;	/* # of EADDRNOTAVAIL */
 	u_long           num_other_errors;	/* # of other errors */
 	u_long           max_conns;	/* max # of concurrent connections */
+	u_long           obj_max_in_use[OBJ_NUM_TYPES];	/* pool high-water
+													 * marks */
+	u_long           obj_allocated[OBJ_NUM_TYPES];	/* pool sizes */
 
 	u_long           num_lifetimes;
 	Time            conn_lifetime_sum;	/* sum of connection lifetimes */
@@ -88,12 +89,35 @@ static struct {
 	Time            reply_rate_max;
 
 	u_long           num_connects;	/* # of completed connect()s */
+	u_long           num_tfo_tried;	/* # set up for TCP Fast Open */
+	u_long           num_tfo_used;	/* # that sent data in the SYN */
 	Time            conn_connect_sum;	/* sum of connect times */
+	Histogram       conn_connect_hist;
+
+	u_long           num_warm;	/* # set up before the test */
+	u_long           num_warm_failed;	/* # that failed to */
+	Time            warm_setup_sum;	/* sum of their setup times */
+	Time            warm_time;	/* duration of the warm-up phase */
+
+	u_long           num_handshakes;	/* # of completed TLS handshakes */
+	Time            handshake_sum;	/* sum of handshake times */
+	Time            handshake_min;
+	Time            handshake_max;
+	u_long           num_resume_offered;	/* # offering a cached session */
+	u_long           num_resumed;	/* # of abbreviated handshakes */
+	u_long           num_early_sent;	/* # sending 0-RTT data */
+	u_long           num_early_accepted;	/* # whose 0-RTT data was used */
 
 	u_long           num_responses;
 	Time            call_response_sum;	/* sum of response times */
+	Histogram       call_response_hist;
+	Histogram       call_intended_hist;	/* response times measured
+						 * from the intended start */
+	Histogram       sched_lag_hist;	/* how late scheduled connections
+					 * or sessions were created */
 
 	Time            call_xfer_sum;	/* sum of response times */
+	Histogram       call_xfer_hist;
 
 	u_long           num_sent;	/* # of requests sent */
 	size_t          req_bytes_sent;
@@ -102,14 +126,45 @@ static struct {
 	u_wide          hdr_bytes_received;	/* sum of all header bytes */
 	u_wide          reply_bytes_received;	/* sum of all data bytes */
 	u_wide          footer_bytes_received;	/* sum of all footer bytes */
+	u_wide          recv_calls;	/* # of system calls receiving replies */
+	u_wide          recv_bytes;	/* # of bytes they received */
+	u_wide          recv_mapped;	/* # of those mapped, not copied */
 
-	u_int           conn_lifetime_hist[NUM_BINS];	/* histogram of
-													 * connection lifetimes */
+	Histogram       conn_lifetime_hist;	/* histogram of connection
+						 * lifetimes */
 } basic;
 
 static u_long    num_active_conns;
 static u_long    num_replies;	/* # of replies received in this interval */
 
+/*
+ * With --threads, the individual reply rate samples are kept so that the
+ * parent can add up the samples that the workers took in the same
+ * interval.
+ */
+static double   *rate_sample;
+static u_long    rate_samples_alloced;
+
+static void
+add_rate_sample(u_long i, double rate)
+{
+	u_long           old;
+
+	if (i >= rate_samples_alloced) {
+		old = rate_samples_alloced;
+		rate_samples_alloced = i + 64;
+		rate_sample = realloc(rate_sample, rate_samples_alloced
+				      * sizeof(rate_sample[0]));
+		if (!rate_sample) {
+			fprintf(stderr, "%s.basic: Out of memory\n", prog_name);
+			exit(1);
+		}
+		memset(rate_sample + old, 0,
+		       (rate_samples_alloced - old) * sizeof(rate_sample[0]));
+	}
+	rate_sample[i] += rate;
+}
+
 static void
 perf_sample(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type call_arg)
 {
@@ -123,6 +178,9 @@ perf_sample(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type call_arg)
 	if (verbose)
 		printf("reply-rate = %-8.1f\n", rate);
 
+	if (param.num_threads > 1)
+		add_rate_sample(basic.num_reply_rates, rate);
+
 	basic.reply_rate_sum += rate;
 	basic.reply_rate_sum2 += SQUARE(rate);
 	if (rate < basic.reply_rate_min)
@@ -212,10 +270,37 @@ conn_connected(Event_Type et, Object * obj, Any_Type reg_arg,
 			   Any_Type call_arg)
 {
 	Conn           *s = (Conn *) obj;
+	Time            connect;
 
 	assert(et == EV_CONN_CONNECTED && object_is_conn(s));
-	basic.conn_connect_sum += timer_now() - s->basic.time_connect_start;
+	if (s->warm)
+		return;		/* set up before the test started */
+
+	connect = timer_now() - s->basic.time_connect_start;
+	basic.conn_connect_sum += connect;
+	histogram_record(&basic.conn_connect_hist, USEC(connect));
 	++basic.num_connects;
+
+#ifdef HAVE_SSL
+	if (param.use_ssl) {
+		Time            t = timer_now() - s->ssl_handshake_start;
+
+		++basic.num_handshakes;
+		basic.handshake_sum += t;
+		if (t < basic.handshake_min)
+			basic.handshake_min = t;
+		if (t > basic.handshake_max)
+			basic.handshake_max = t;
+		basic.num_resume_offered += s->ssl_offered;
+		basic.num_resumed += SSL_session_reused(s->ssl) != 0;
+		basic.num_early_sent += s->ssl_early_sent;
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+		if (s->ssl_early_sent && SSL_get_early_data_status(s->ssl)
+		    == SSL_EARLY_DATA_ACCEPTED)
+			++basic.num_early_accepted;
+#endif
+	}
+#endif
 }
 
 static void
@@ -223,7 +308,6 @@ conn_destroyed(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type c_arg)
 {
 	Conn           *s = (Conn *) obj;
 	Time            lifetime;
-	u_int           bin;
 
 	assert(et == EV_CONN_DESTROYED && object_is_conn(s)
 		   && num_active_conns > 0);
@@ -237,11 +321,7 @@ conn_destroyed(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type c_arg)
 		if (lifetime > basic.conn_lifetime_max)
 			basic.conn_lifetime_max = lifetime;
 		++basic.num_lifetimes;
-
-		bin = lifetime * NUM_BINS / MAX_LIFETIME;
-		if (bin >= NUM_BINS)
-			bin = NUM_BINS;
-		++basic.conn_lifetime_hist[bin];
+		histogram_record(&basic.conn_lifetime_hist, USEC(lifetime));
 	}
 	--num_active_conns;
 }
@@ -254,6 +334,8 @@ send_start(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type call_arg)
 	assert(et == EV_CALL_SEND_START && object_is_call(c));
 
 	c->basic.time_send_start = timer_now();
+	if (c->time_intended > 0)
+		histogram_record(&basic.sched_lag_hist, USEC(c->sched_lag));
 }
 
 static void
@@ -271,13 +353,28 @@ static void
 recv_start(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type call_arg)
 {
 	Call           *c = (Call *) obj;
-	Time            now;
+	Time            now, response;
 
 	assert(et == EV_CALL_RECV_START && object_is_call(c));
 
+	/*
+	 * A 100 Continue is followed by the real reply: 
+	 */
+	if (c->reply.status / 100 == 1)
+		return;
+
 	now = timer_now();
 
-	basic.call_response_sum += now - c->basic.time_send_start;
+	response = now - c->basic.time_send_start;
+	basic.call_response_sum += response;
+	histogram_record(&basic.call_response_hist, USEC(response));
+	/*
+	 * A call that fell behind the schedule would have been waiting for
+	 * its reply ever since it was meant to be sent: 
+	 */
+	if (c->time_intended > 0)
+		response = now - c->time_intended;
+	histogram_record(&basic.call_intended_hist, USEC(response));
 	c->basic.time_recv_start = now;
 	++basic.num_responses;
 
@@ -295,18 +392,22 @@ recv_stop(Event_Type et, Object * obj, Any_Type reg_arg, Any_Type call_arg)
 {
 	Call           *c = (Call *) obj;
 	int             index;
+	Time            xfer;
 
 	assert(et == EV_CALL_RECV_STOP && object_is_call(c));
 	assert(c->basic.time_recv_start > 0);
 
-	basic.call_xfer_sum += timer_now() - c->basic.time_recv_start;
+	xfer = timer_now() - c->basic.time_recv_start;
+	basic.call_xfer_sum += xfer;
+	histogram_record(&basic.call_xfer_hist, USEC(xfer));
 
 	basic.hdr_bytes_received += c->reply.header_bytes;
 	basic.reply_bytes_received += c->reply.content_bytes;
 	basic.footer_bytes_received += c->reply.footer_bytes;
 
 	index = (c->reply.status / 100);
-	assert((unsigned) index < NELEMS(basic.num_replies));
+	if ((unsigned) index >= NELEMS(basic.num_replies))
+		index = 0;	/* no such status class */
 	++basic.num_replies[index];
 	++num_replies;
 
@@ -337,6 +438,13 @@ init(void)
 
 	basic.conn_lifetime_min = DBL_MAX;
 	basic.reply_rate_min = DBL_MAX;
+	basic.handshake_min = DBL_MAX;
+	histogram_init(&basic.conn_lifetime_hist);
+	histogram_init(&basic.conn_connect_hist);
+	histogram_init(&basic.call_response_hist);
+	histogram_init(&basic.call_intended_hist);
+	histogram_init(&basic.sched_lag_hist);
+	histogram_init(&basic.call_xfer_hist);
 
 	arg.l = 0;
 	event_register_handler(EV_PERF_SAMPLE, perf_sample, arg);
@@ -355,6 +463,149 @@ init(void)
 		timer_schedule(one_second_timer, arg, 1);
 }
 
+static void
+stop(void)
+{
+	int             i;
+
+	for (i = 0; i < OBJ_NUM_TYPES; ++i)
+		object_stats(i, &basic.obj_max_in_use[i],
+			     &basic.obj_allocated[i]);
+	core_recv_stats(&basic.recv_calls, &basic.recv_bytes,
+			&basic.recv_mapped);
+	core_tfo_stats(&basic.num_tfo_tried, &basic.num_tfo_used);
+	core_warm_stats(&basic.num_warm, &basic.num_warm_failed,
+			&basic.warm_setup_sum, &basic.warm_time);
+}
+
+static void
+save(int fd)
+{
+	write_fully(fd, &basic, sizeof(basic));
+	write_fully(fd, rate_sample,
+		    basic.num_reply_rates * sizeof(rate_sample[0]));
+}
+
+static void
+merge(int fd)
+{
+	static u_long    max_rate_samples;
+	u_long           i;
+	double           rate;
+	struct Basic_Stats *w;
+
+	w = malloc(sizeof(*w));
+	if (!w || read_fully(fd, w, sizeof(*w)) < 0)
+		panic("%s.basic: failed to merge worker statistics\n",
+		      prog_name);
+
+	basic.num_conns_issued += w->num_conns_issued;
+	for (i = 0; i < NELEMS(basic.num_replies); ++i)
+		basic.num_replies[i] += w->num_replies[i];
+	basic.num_200 += w->num_200;
+	basic.num_302 += w->num_302;
+	basic.num_client_timeouts += w->num_client_timeouts;
+	basic.num_sock_fdunavail += w->num_sock_fdunavail;
+	basic.num_sock_ftabfull += w->num_sock_ftabfull;
+	basic.num_sock_refused += w->num_sock_refused;
+	basic.num_sock_reset += w->num_sock_reset;
+	basic.num_sock_timeouts += w->num_sock_timeouts;
+	basic.num_sock_addrunavail += w->num_sock_addrunavail;
+	basic.num_other_errors += w->num_other_errors;
+	basic.max_conns += w->max_conns;
+	for (i = 0; i < OBJ_NUM_TYPES; ++i) {
+		basic.obj_max_in_use[i] += w->obj_max_in_use[i];
+		basic.obj_allocated[i] += w->obj_allocated[i];
+	}
+
+	basic.num_lifetimes += w->num_lifetimes;
+	basic.conn_lifetime_sum += w->conn_lifetime_sum;
+	basic.conn_lifetime_sum2 += w->conn_lifetime_sum2;
+	if (w->conn_lifetime_min < basic.conn_lifetime_min)
+		basic.conn_lifetime_min = w->conn_lifetime_min;
+	if (w->conn_lifetime_max > basic.conn_lifetime_max)
+		basic.conn_lifetime_max = w->conn_lifetime_max;
+
+	basic.num_connects += w->num_connects;
+	basic.conn_connect_sum += w->conn_connect_sum;
+	histogram_merge(&basic.conn_connect_hist, &w->conn_connect_hist);
+	basic.num_tfo_tried += w->num_tfo_tried;
+	basic.num_tfo_used += w->num_tfo_used;
+	basic.num_warm += w->num_warm;
+	basic.num_warm_failed += w->num_warm_failed;
+	basic.warm_setup_sum += w->warm_setup_sum;
+	if (w->warm_time > basic.warm_time)
+		basic.warm_time = w->warm_time;
+	basic.num_handshakes += w->num_handshakes;
+	basic.handshake_sum += w->handshake_sum;
+	if (w->handshake_min < basic.handshake_min)
+		basic.handshake_min = w->handshake_min;
+	if (w->handshake_max > basic.handshake_max)
+		basic.handshake_max = w->handshake_max;
+	basic.num_resume_offered += w->num_resume_offered;
+	basic.num_resumed += w->num_resumed;
+	basic.num_early_sent += w->num_early_sent;
+	basic.num_early_accepted += w->num_early_accepted;
+	basic.num_responses += w->num_responses;
+	basic.call_response_sum += w->call_response_sum;
+	basic.call_xfer_sum += w->call_xfer_sum;
+	histogram_merge(&basic.call_response_hist, &w->call_response_hist);
+	histogram_merge(&basic.call_intended_hist, &w->call_intended_hist);
+	histogram_merge(&basic.sched_lag_hist, &w->sched_lag_hist);
+	histogram_merge(&basic.call_xfer_hist, &w->call_xfer_hist);
+	basic.num_sent += w->num_sent;
+	basic.req_bytes_sent += w->req_bytes_sent;
+	basic.num_received += w->num_received;
+	basic.hdr_bytes_received += w->hdr_bytes_received;
+	basic.reply_bytes_received += w->reply_bytes_received;
+	basic.footer_bytes_received += w->footer_bytes_received;
+	basic.recv_calls += w->recv_calls;
+	basic.recv_bytes += w->recv_bytes;
+	basic.recv_mapped += w->recv_mapped;
+
+	histogram_merge(&basic.conn_lifetime_hist, &w->conn_lifetime_hist);
+
+	for (i = 0; i < w->num_reply_rates; ++i) {
+		if (read_fully(fd, &rate, sizeof(rate)) < 0)
+			panic("%s.basic: failed to merge worker statistics\n",
+			      prog_name);
+		add_rate_sample(i, rate);
+	}
+	if (w->num_reply_rates > max_rate_samples)
+		max_rate_samples = w->num_reply_rates;
+	free(w);
+
+	/*
+	 * The merged samples are the sums of what the workers observed in the 
+	 * same interval: 
+	 */
+	basic.num_reply_rates = max_rate_samples;
+	basic.reply_rate_sum = basic.reply_rate_sum2 = 0.0;
+	basic.reply_rate_min = DBL_MAX;
+	basic.reply_rate_max = 0.0;
+	for (i = 0; i < max_rate_samples; ++i) {
+		rate = rate_sample[i];
+		basic.reply_rate_sum += rate;
+		basic.reply_rate_sum2 += SQUARE(rate);
+		if (rate < basic.reply_rate_min)
+			basic.reply_rate_min = rate;
+		if (rate > basic.reply_rate_max)
+			basic.reply_rate_max = rate;
+	}
+}
+
+static void
+print_percentiles(const char *what, const Histogram * h)
+{
+	u_int           i;
+
+	printf("%s", what);
+	for (i = 0; i < param.percentiles.num; ++i)
+		printf(" p%g %.3f", param.percentiles.p[i],
+		       1e-3 * histogram_percentile(h, param.percentiles.p[i]));
+	printf(" max %.3f\n", 1e-3 * h->max);
+}
+
 static void
 dump(void)
 {
@@ -369,26 +620,12 @@ dump(void)
 	u_long          total_replies = 0;
 	Time            delta, user, sys;
 	u_wide          total_size;
-	Time            time;
-	u_int           n;
 
-	for (i = 1; i < NELEMS(basic.num_replies); ++i)
+	for (i = 0; i < NELEMS(basic.num_replies); ++i)
 		total_replies += basic.num_replies[i];
 
 	delta = test_time_stop - test_time_start;
 
-	if (verbose > 1) {
-		printf("\nConnection lifetime histogram (time in ms):\n");
-		for (i = 0; i < NUM_BINS; ++i)
-			if (basic.conn_lifetime_hist[i]) {
-				if (i > 0 && basic.conn_lifetime_hist[i - 1] == 0)
-					printf("%14c\n", ':');
-				time = (i + 0.5) * BIN_WIDTH;
-				printf("%16.1f %u\n", 1e3 * time,
-					   basic.conn_lifetime_hist[i]);
-			}
-	}
-
 	printf("\nTotal: connections %lu requests %lu replies %lu "
 		   "test-duration %.3f s\n",
 		   basic.num_conns_issued, basic.num_sent, total_replies, delta);
@@ -408,14 +645,8 @@ dump(void)
 			lifetime_stddev = STDDEV(basic.conn_lifetime_sum,
 									 basic.conn_lifetime_sum2,
 									 basic.num_lifetimes);
-		n = 0;
-		for (i = 0; i < NUM_BINS; ++i) {
-			n += basic.conn_lifetime_hist[i];
-			if (n >= 0.5 * basic.num_lifetimes) {
-				lifetime_median = (i + 0.5) * BIN_WIDTH;
-				break;
-			}
-		}
+		lifetime_median =
+		    1e-6 * histogram_percentile(&basic.conn_lifetime_hist, 50);
 	}
 	printf("Connection time [ms]: min %.1f avg %.1f max %.1f median %.1f "
 		   "stddev %.1f\n",
@@ -423,12 +654,46 @@ dump(void)
 		   1e3 * lifetime_avg,
 		   1e3 * basic.conn_lifetime_max, 1e3 * lifetime_median,
 		   1e3 * lifetime_stddev);
+	print_percentiles("Connection time percentiles [ms]: lifetime",
+			  &basic.conn_lifetime_hist);
 	if (basic.num_connects > 0)
 		conn_time = basic.conn_connect_sum / basic.num_connects;
 	printf("Connection time [ms]: connect %.1f\n", 1e3 * conn_time);
+	print_percentiles("Connection time percentiles [ms]: connect",
+			  &basic.conn_connect_hist);
 	printf("Connection length [replies/conn]: %.3f\n",
 		   basic.num_lifetimes > 0
 		   ? total_replies / (double) basic.num_lifetimes : 0.0);
+	if (param.warm_conns)
+		printf("Connection warm-up: established %lu failed %lu "
+			   "setup avg %.1f ms (%.3f s)\n", basic.num_warm,
+			   basic.num_warm_failed, basic.num_warm > 0
+			   ? 1e3 * basic.warm_setup_sum / basic.num_warm : 0.0,
+			   basic.warm_time);
+	if (param.tfo)
+		printf("Connection Fast Open: tried %lu data-in-SYN %lu "
+			   "(%.1f%%)\n", basic.num_tfo_tried, basic.num_tfo_used,
+			   basic.num_tfo_tried > 0 ? 100.0 * basic.num_tfo_used
+			   / basic.num_tfo_tried : 0.0);
+#ifdef HAVE_SSL
+	if (param.use_ssl) {
+		u_int           n = basic.num_handshakes;
+
+		printf("TLS handshake [ms]: min %.1f avg %.1f max %.1f "
+			   "(%lu handshakes)\n",
+			   n > 0 ? 1e3 * basic.handshake_min : 0.0,
+			   n > 0 ? 1e3 * basic.handshake_sum / n : 0.0,
+			   1e3 * basic.handshake_max, basic.num_handshakes);
+		printf("TLS resumption: offered %lu resumed %lu (%.1f%%) "
+			   "early-data sent %lu accepted %lu (%.1f%%)\n",
+			   basic.num_resume_offered, basic.num_resumed,
+			   n > 0 ? 100.0 * basic.num_resumed / n : 0.0,
+			   basic.num_early_sent, basic.num_early_accepted,
+			   basic.num_early_sent > 0 ? 100.0
+			   * basic.num_early_accepted / basic.num_early_sent
+			   : 0.0);
+	}
+#endif
 	putchar('\n');
 
 	if (basic.num_sent > 0)
@@ -462,6 +727,16 @@ dump(void)
 		xfer_time = basic.call_xfer_sum / total_replies;
 	printf("Reply time [ms]: response %.1f transfer %.1f\n",
 		   1e3 * resp_time, 1e3 * xfer_time);
+	print_percentiles("Reply time percentiles [ms]: response",
+			  &basic.call_response_hist);
+	print_percentiles("Reply time percentiles [ms]: transfer",
+			  &basic.call_xfer_hist);
+	if (param.rate.rate_param > 0.0) {
+		print_percentiles("Reply time percentiles [ms]: intended",
+				  &basic.call_intended_hist);
+		print_percentiles("Schedule lag percentiles [ms]: create",
+				  &basic.sched_lag_hist);
+	}
 
 	if (total_replies) {
 		hdr_size = basic.hdr_bytes_received / total_replies;
@@ -472,9 +747,11 @@ dump(void)
 		   "(total %.1f)\n", hdr_size, reply_size, footer_size,
 		   hdr_size + reply_size + footer_size);
 
-	printf("Reply status: 1xx=%lu 2xx=%lu 3xx=%lu 4xx=%lu 5xx=%lu\n",
+	printf("Reply status: 1xx=%lu 2xx=%lu 3xx=%lu 4xx=%lu 5xx=%lu "
+		   "invalid=%lu\n",
 		   basic.num_replies[1], basic.num_replies[2],
-		   basic.num_replies[3], basic.num_replies[4], basic.num_replies[5]);
+		   basic.num_replies[3], basic.num_replies[4], basic.num_replies[5],
+		   basic.num_replies[0]);
 
 	putchar('\n');
 
@@ -483,6 +760,12 @@ dump(void)
 		putchar('\n');
 	}
 
+	printf("Object pools [max in use/allocated]: conn %lu/%lu "
+		   "call %lu/%lu sess %lu/%lu\n",
+		   basic.obj_max_in_use[OBJ_CONN], basic.obj_allocated[OBJ_CONN],
+		   basic.obj_max_in_use[OBJ_CALL], basic.obj_allocated[OBJ_CALL],
+		   basic.obj_max_in_use[OBJ_SESS], basic.obj_allocated[OBJ_SESS]);
+
 	user = (TV_TO_SEC(test_rusage_stop.ru_utime)
 			- TV_TO_SEC(test_rusage_start.ru_utime));
 	sys = (TV_TO_SEC(test_rusage_stop.ru_stime)
@@ -496,6 +779,13 @@ dump(void)
 				  + basic.hdr_bytes_received + basic.reply_bytes_received);
 	printf("Net I/O: %.1f KB/s (%.1f*10^6 bps)\n",
 		   total_size / delta / 1024.0, 8e-6 * total_size / delta);
+	if (basic.recv_calls > 0)
+		printf("Net I/O receive: %.1f bytes/syscall (%.0f syscalls, "
+			   "%.1f%% zero-copy)\n",
+			   (double) basic.recv_bytes / basic.recv_calls,
+			   (double) basic.recv_calls,
+			   basic.recv_bytes > 0 ?
+			   100.0 * basic.recv_mapped / basic.recv_bytes : 0.0);
 
 	putchar('\n');
 
@@ -516,6 +806,8 @@ Stat_Collector  stats_basic = {
 	"Basic statistics",
 	init,
 	no_op,
-	no_op,
-	dump
+	stop,
+	dump,
+	save,
+	merge
 };
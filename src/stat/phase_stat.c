@@ -0,0 +1,295 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+/* Breaks the time spent on connections and calls down into the
+   phases delimited by the events: hostname lookup, TCP connection
+   setup, TLS handshake, sending the request, waiting for the first
+   byte of the reply, and receiving the rest of it.  Each phase gets
+   its own histogram so that a change in latency can be traced to the
+   phase it comes from.  */
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <generic_types.h>
+#include <histogram.h>
+
+#include <object.h>
+#include <timer.h>
+#include <httperf.h>
+#include <call.h>
+#include <conn.h>
+#include <localevent.h>
+#include <stats.h>
+
+typedef enum Phase
+  {
+    PH_LOOKUP,		/* hostname lookup */
+    PH_CONNECT,		/* TCP connection setup */
+    PH_HANDSHAKE,	/* TLS handshake */
+    PH_SEND,		/* sending the request */
+    PH_WAIT,		/* request sent until first byte of reply */
+    PH_RECV,		/* first byte until end of reply */
+    PH_NUM_PHASES
+  }
+Phase;
+
+static const char *const phase_name[PH_NUM_PHASES] =
+  {
+    "lookup", "connect", "tls", "send", "wait", "receive"
+  };
+
+static struct Phase_Stats
+  {
+    Time sum[PH_NUM_PHASES];
+    Histogram hist[PH_NUM_PHASES];
+  }
+st;
+
+typedef struct Conn_Private_Data
+  {
+    Time connect_start;		/* when the connection was initiated */
+  }
+Conn_Private_Data;
+
+typedef struct Call_Private_Data
+  {
+    Time send_start;		/* when the first byte went out */
+    Time send_stop;		/* when the last byte went out */
+    Time recv_start;		/* when the first byte came in */
+  }
+Call_Private_Data;
+
+#define CONN_PRIVATE_DATA(c)						\
+  ((Conn_Private_Data *) ((char *)(c) + conn_private_data_offset))
+#define CALL_PRIVATE_DATA(c)						\
+  ((Call_Private_Data *) ((char *)(c) + call_private_data_offset))
+
+static size_t conn_private_data_offset;
+static size_t call_private_data_offset;
+static Time lookup_start;
+
+static void
+record (Phase ph, Time t)
+{
+  if (t < 0)
+    t = 0;
+  st.sum[ph] += t;
+  histogram_record (&st.hist[ph], USEC (t));
+}
+
+static void
+lookup_started (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  assert (et == EV_HOSTNAME_LOOKUP_START);
+  lookup_start = timer_now_forced ();
+}
+
+static void
+lookup_stopped (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  assert (et == EV_HOSTNAME_LOOKUP_STOP);
+  record (PH_LOOKUP, timer_now_forced () - lookup_start);
+}
+
+static void
+conn_connecting (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Conn *s = (Conn *) obj;
+
+  assert (et == EV_CONN_CONNECTING && object_is_conn (s));
+  CONN_PRIVATE_DATA (s)->connect_start = timer_now ();
+}
+
+static void
+conn_connected (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Conn *s = (Conn *) obj;
+  Time start, now;
+
+  assert (et == EV_CONN_CONNECTED && object_is_conn (s));
+  if (s->warm)
+    return;		/* set up before the test started */
+
+  now = timer_now ();
+  start = CONN_PRIVATE_DATA (s)->connect_start;
+#ifdef HAVE_SSL
+  /* EV_CONN_CONNECTED is signalled only once the handshake is done: */
+  if (param.use_ssl && s->ssl_handshake_start >= start)
+    {
+      record (PH_CONNECT, s->ssl_handshake_start - start);
+      record (PH_HANDSHAKE, now - s->ssl_handshake_start);
+      return;
+    }
+#endif
+  record (PH_CONNECT, now - start);
+}
+
+static void
+send_start (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Call *c = (Call *) obj;
+
+  assert (et == EV_CALL_SEND_START && object_is_call (c));
+  CALL_PRIVATE_DATA (c)->send_start = timer_now ();
+}
+
+static void
+send_stop (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Call_Private_Data *priv;
+  Call *c = (Call *) obj;
+
+  assert (et == EV_CALL_SEND_STOP && object_is_call (c));
+  priv = CALL_PRIVATE_DATA (c);
+  priv->send_stop = timer_now ();
+  record (PH_SEND, priv->send_stop - priv->send_start);
+}
+
+static void
+recv_start (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Call_Private_Data *priv;
+  Call *c = (Call *) obj;
+
+  assert (et == EV_CALL_RECV_START && object_is_call (c));
+  /* a 100 Continue is followed by the real reply: */
+  if (c->reply.status / 100 == 1)
+    return;
+
+  priv = CALL_PRIVATE_DATA (c);
+  priv->recv_start = timer_now ();
+  /* the server may start replying before it got the whole request, in
+     which case there was no wait to speak of: */
+  if (priv->send_stop > 0)
+    record (PH_WAIT, priv->recv_start - priv->send_stop);
+}
+
+static void
+recv_stop (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Call *c = (Call *) obj;
+
+  assert (et == EV_CALL_RECV_STOP && object_is_call (c));
+  record (PH_RECV, timer_now () - CALL_PRIVATE_DATA (c)->recv_start);
+}
+
+static void
+init (void)
+{
+  Any_Type arg;
+  int i;
+
+  conn_private_data_offset = object_expand (OBJ_CONN,
+					    sizeof (Conn_Private_Data));
+  call_private_data_offset = object_expand (OBJ_CALL,
+					    sizeof (Call_Private_Data));
+  for (i = 0; i < PH_NUM_PHASES; ++i)
+    histogram_init (&st.hist[i]);
+
+  arg.l = 0;
+  event_register_handler (EV_HOSTNAME_LOOKUP_START, lookup_started, arg);
+  event_register_handler (EV_HOSTNAME_LOOKUP_STOP, lookup_stopped, arg);
+  event_register_handler (EV_CONN_CONNECTING, conn_connecting, arg);
+  event_register_handler (EV_CONN_CONNECTED, conn_connected, arg);
+  event_register_handler (EV_CALL_SEND_START, send_start, arg);
+  event_register_handler (EV_CALL_SEND_STOP, send_stop, arg);
+  event_register_handler (EV_CALL_RECV_START, recv_start, arg);
+  event_register_handler (EV_CALL_RECV_STOP, recv_stop, arg);
+}
+
+static void
+save (int fd)
+{
+  write_fully (fd, &st, sizeof (st));
+}
+
+static void
+merge (int fd)
+{
+  struct Phase_Stats *w;
+  int i;
+
+  w = malloc (sizeof (*w));
+  if (!w || read_fully (fd, w, sizeof (*w)) < 0)
+    panic ("%s.phase_stat: failed to merge worker statistics\n", prog_name);
+
+  for (i = 0; i < PH_NUM_PHASES; ++i)
+    {
+      st.sum[i] += w->sum[i];
+      histogram_merge (&st.hist[i], &w->hist[i]);
+    }
+  free (w);
+}
+
+static void
+dump (void)
+{
+  const Histogram *h;
+  u_int i, j;
+
+  putchar ('\n');
+  for (i = 0; i < PH_NUM_PHASES; ++i)
+    {
+#ifdef HAVE_SSL
+      if (i == PH_HANDSHAKE && !param.use_ssl)
+	continue;
+#else
+      if (i == PH_HANDSHAKE)
+	continue;
+#endif
+      h = &st.hist[i];
+
+      printf ("Phase time [ms]: %-7s avg %.3f", phase_name[i],
+	      h->total > 0 ? 1e3 * st.sum[i] / h->total : 0.0);
+      for (j = 0; j < param.percentiles.num; ++j)
+	printf (" p%g %.3f", param.percentiles.p[j],
+		1e-3 * histogram_percentile (h, param.percentiles.p[j]));
+      printf (" max %.3f (%llu samples)\n", 1e-3 * h->max,
+	      (unsigned long long) h->total);
+    }
+}
+
+Stat_Collector phase_stat =
+  {
+    "breaks latencies down by phase",
+    init,
+    no_op,
+    no_op,
+    dump,
+    save,
+    merge
+  };
@@ -52,7 +52,7 @@
 #include <session.h>
 #include <stats.h>
 
-static struct
+static struct Sess_Stats
   {
     u_int num_rate_samples;
     u_int num_completed_since_last_sample;
@@ -89,6 +89,54 @@ Sess_Private_Data;
 
 static size_t sess_private_data_offset = -1;
 
+/* With --threads, the individual session rate samples are kept so
+   that the parent can add up the samples that the workers took in the
+   same interval.  */
+static double *rate_sample;
+static u_int rate_samples_alloced;
+
+static void
+add_rate_sample (u_int i, double rate)
+{
+  u_int old;
+
+  if (i >= rate_samples_alloced)
+    {
+      old = rate_samples_alloced;
+      rate_samples_alloced = i + 64;
+      rate_sample = realloc (rate_sample,
+			     rate_samples_alloced*sizeof (rate_sample[0]));
+      if (!rate_sample)
+	{
+	  fprintf (stderr, "%s.sess_stat: Out of memory\n", prog_name);
+	  exit (1);
+	}
+      memset (rate_sample + old, 0,
+	      (rate_samples_alloced - old)*sizeof (rate_sample[0]));
+    }
+  rate_sample[i] += rate;
+}
+
+static void
+grow_len_hist (u_int longest_session)
+{
+  size_t old_size, new_size;
+
+  if (longest_session < st.len_hist_alloced)
+    return;
+
+  old_size = st.len_hist_alloced*sizeof (st.len_hist[0]);
+  st.len_hist_alloced = longest_session + 16;
+  new_size = st.len_hist_alloced*sizeof (st.len_hist[0]);
+
+  st.len_hist = realloc (st.len_hist, new_size);
+  if (!st.len_hist)
+    {
+      fprintf (stderr, "%s.sess_stat: Out of memory\n", prog_name);
+      exit (1);
+    }
+  memset ((char *) st.len_hist + old_size, 0, new_size - old_size);
+}
 
 static void
 perf_sample (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type call_arg)
@@ -104,6 +152,9 @@ perf_sample (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type call_arg)
   if (verbose)
     printf ("session-rate = %-8.1f\n", rate);
 
+  if (param.num_threads > 1)
+    add_rate_sample (st.num_rate_samples, rate);
+
   ++st.num_rate_samples;
   st.rate_sum += rate;
   st.rate_sum2 += SQUARE (rate);
@@ -128,7 +179,6 @@ sess_created (Event_Type et, Object *obj, Any_Type regarg, Any_Type callarg)
 static void
 sess_destroyed (Event_Type et, Object *obj, Any_Type regarg, Any_Type callarg)
 {
-  size_t old_size, new_size;
   Sess_Private_Data *priv;
   Sess *sess;
   Time delta, now = timer_now ();
@@ -154,21 +204,7 @@ sess_destroyed (Event_Type et, Object *obj, Any_Type regarg, Any_Type callarg)
   if (priv->num_calls_completed > st.longest_session)
     {
       st.longest_session = priv->num_calls_completed;
-
-      if (st.longest_session >= st.len_hist_alloced)
-	{
-	  old_size = st.len_hist_alloced*sizeof (st.len_hist[0]);
-	  st.len_hist_alloced = st.longest_session + 16;
-	  new_size = st.len_hist_alloced*sizeof (st.len_hist[0]);
-
-	  st.len_hist = realloc (st.len_hist, new_size);
-	  if (!st.len_hist)
-	    {
-	      fprintf (stderr, "%s.sess_stat: Out of memory\n", prog_name);
-	      exit (1);
-	    }
-	  memset ((char *) st.len_hist + old_size, 0, new_size - old_size);
-	}
+      grow_len_hist (st.longest_session);
     }
   ++st.len_hist[priv->num_calls_completed];
 }
@@ -231,6 +267,76 @@ init (void)
   event_register_handler (EV_CALL_RECV_STOP, call_done, arg);
 }
 
+static void
+save (int fd)
+{
+  write_fully (fd, &st, sizeof (st));
+  write_fully (fd, st.len_hist,
+	       (st.longest_session + 1)*sizeof (st.len_hist[0]));
+  write_fully (fd, rate_sample,
+	       st.num_rate_samples*sizeof (rate_sample[0]));
+}
+
+static void
+merge (int fd)
+{
+  static u_int max_rate_samples;
+  struct Sess_Stats w;
+  u_int i, len;
+  double rate;
+
+  if (read_fully (fd, &w, sizeof (w)) < 0)
+    goto failure;
+
+  st.num_completed += w.num_completed;
+  st.lifetime_sum += w.lifetime_sum;
+  st.num_failed += w.num_failed;
+  st.failtime_sum += w.failtime_sum;
+  st.num_conns += w.num_conns;
+
+  if (w.longest_session > st.longest_session)
+    {
+      st.longest_session = w.longest_session;
+      grow_len_hist (st.longest_session);
+    }
+  for (i = 0; i <= w.longest_session; ++i)
+    {
+      if (read_fully (fd, &len, sizeof (len)) < 0)
+	goto failure;
+      st.len_hist[i] += len;
+    }
+
+  for (i = 0; i < w.num_rate_samples; ++i)
+    {
+      if (read_fully (fd, &rate, sizeof (rate)) < 0)
+	goto failure;
+      add_rate_sample (i, rate);
+    }
+  if (w.num_rate_samples > max_rate_samples)
+    max_rate_samples = w.num_rate_samples;
+
+  /* The merged samples are the sums of what the workers observed in
+     the same interval: */
+  st.num_rate_samples = max_rate_samples;
+  st.rate_sum = st.rate_sum2 = 0.0;
+  st.rate_min = DBL_MAX;
+  st.rate_max = 0.0;
+  for (i = 0; i < max_rate_samples; ++i)
+    {
+      rate = rate_sample[i];
+      st.rate_sum += rate;
+      st.rate_sum2 += SQUARE (rate);
+      if (rate < st.rate_min)
+	st.rate_min = rate;
+      if (rate > st.rate_max)
+	st.rate_max = rate;
+    }
+  return;
+
+ failure:
+  panic ("%s.sess_stat: failed to merge worker statistics\n", prog_name);
+}
+
 static void
 dump (void)
 {
@@ -279,5 +385,7 @@ Stat_Collector session_stat =
     init,
     no_op,
     no_op,
-    dump
+    dump,
+    save,
+    merge
   };
@@ -40,4 +40,7 @@
 #define VAR(s,s2,n)	(((n) < 2) ? 0.0 : ((s2) - SQUARE(s)/(n)) / ((n) - 1))
 #define STDDEV(s,s2,n)	(((n) < 2) ? 0.0 : sqrt (VAR ((s), (s2), (n))))
 
+/* Latency histograms count microseconds.  */
+#define USEC(t)		((t) > 0 ? (u_wide) (1e6*(t) + 0.5) : 0)
+
 #endif /* stats_h */
@@ -0,0 +1,341 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+    
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+    02110-1301, USA
+*/
+
+/* Reply times by URI or request class.  A call is counted under the
+   class its load generator gave it (e.g., with a class= option in a
+   --wsesslog file), else under the longest --uri-class prefix its URI
+   starts with, else under its URI.  The keys are interned in an open
+   addressing hash table.  Each key has its own compact histogram.  To
+   keep memory bounded, keys seen after the first
+   PARAM.URI_STATS.MAX_KEYS are all counted as "other".  */
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <generic_types.h>
+#include <histogram.h>
+
+#include <object.h>
+#include <timer.h>
+#include <httperf.h>
+#include <call.h>
+#include <localevent.h>
+#include <stats.h>
+
+typedef struct Key_Stats
+  {
+    char *key;			/* interned copy of the key */
+    size_t len;
+    u_int hash;
+    u_wide p99;			/* used for sorting only */
+    Time sum;			/* sum of reply times */
+    Compact_Histogram hist;	/* reply times in microseconds */
+  }
+Key_Stats;
+
+typedef struct Call_Private_Data
+  {
+    Time send_start;
+  }
+Call_Private_Data;
+
+#define CALL_PRIVATE_DATA(c)						\
+  ((Call_Private_Data *) ((char *)(c) + call_private_data_offset))
+
+static size_t call_private_data_offset;
+
+static Key_Stats **key;		/* key[0] is "other" */
+static u_int num_keys;		/* # of keys, including "other" */
+static u_int *table;		/* indices into KEY (0 = empty slot) */
+static u_int table_mask;
+
+static struct
+  {
+    const char *prefix;
+    size_t len;
+  }
+*uri_class;
+static u_int num_uri_classes;
+
+static Key_Stats *
+new_key (const char *str, size_t len, u_int hash)
+{
+  Key_Stats *k;
+
+  k = malloc (sizeof (*k));
+  if (k)
+    k->key = malloc (len + 1);
+  if (!k || !k->key)
+    panic ("%s.uri_stat: out of memory\n", prog_name);
+  memcpy (k->key, str, len);
+  k->key[len] = '\0';
+  k->len = len;
+  k->hash = hash;
+  k->sum = 0.0;
+  compact_histogram_init (&k->hist);
+  return k;
+}
+
+static Key_Stats *
+intern (const char *str, size_t len)
+{
+  u_int hash, i;
+  Key_Stats *k;
+  size_t n;
+
+  hash = 2166136261u;		/* FNV-1a */
+  for (n = 0; n < len; ++n)
+    hash = (hash ^ (u_char) str[n]) * 16777619u;
+
+  for (i = hash & table_mask; table[i]; i = (i + 1) & table_mask)
+    {
+      k = key[table[i]];
+      if (k->hash == hash && k->len == len && memcmp (k->key, str, len) == 0)
+	return k;
+    }
+  if (num_keys > param.uri_stats.max_keys)
+    return key[0];
+
+  k = new_key (str, len, hash);
+  key[num_keys] = k;
+  table[i] = num_keys++;
+  return k;
+}
+
+static Key_Stats *
+call_key (Call *c)
+{
+  const char *uri = c->req.iov[IE_URI].iov_base;
+  size_t uri_len = c->req.iov[IE_URI].iov_len;
+  size_t best_len = 0;
+  const char *best = 0;
+  u_int i;
+
+  if (c->req.stat_class)
+    return intern (c->req.stat_class, strlen (c->req.stat_class));
+
+  for (i = 0; i < num_uri_classes; ++i)
+    if (uri_class[i].len <= uri_len && uri_class[i].len > best_len
+	&& memcmp (uri, uri_class[i].prefix, uri_class[i].len) == 0)
+      {
+	best = uri_class[i].prefix;
+	best_len = uri_class[i].len;
+      }
+  if (best)
+    return intern (best, best_len);
+  return intern (uri, uri_len);
+}
+
+static void
+record (Key_Stats *k, Time t)
+{
+  k->sum += t;
+  compact_histogram_record (&k->hist, USEC (t));
+}
+
+static void
+send_start (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Call *c = (Call *) obj;
+
+  assert (et == EV_CALL_SEND_START && object_is_call (c));
+  CALL_PRIVATE_DATA (c)->send_start = timer_now ();
+}
+
+static void
+recv_stop (Event_Type et, Object *obj, Any_Type reg_arg, Any_Type arg)
+{
+  Call *c = (Call *) obj;
+
+  assert (et == EV_CALL_RECV_STOP && object_is_call (c));
+  record (call_key (c), timer_now () - CALL_PRIVATE_DATA (c)->send_start);
+}
+
+static void
+init (void)
+{
+  char *classes, *cp;
+  u_int size;
+  Any_Type arg;
+
+  call_private_data_offset = object_expand (OBJ_CALL,
+					    sizeof (Call_Private_Data));
+
+  for (size = 2; size < 2*(param.uri_stats.max_keys + 1); size *= 2);
+  table_mask = size - 1;
+  table = calloc (size, sizeof (table[0]));
+  key = malloc ((param.uri_stats.max_keys + 1) * sizeof (key[0]));
+  if (!table || !key)
+    panic ("%s.uri_stat: out of memory\n", prog_name);
+  key[0] = new_key ("other", 5, 0);
+  num_keys = 1;
+
+  if (param.uri_stats.classes)
+    {
+      classes = strdup (param.uri_stats.classes);
+      uri_class = malloc ((strlen (classes) / 2 + 1) * sizeof (uri_class[0]));
+      if (!classes || !uri_class)
+	panic ("%s.uri_stat: out of memory\n", prog_name);
+      for (cp = strtok (classes, ","); cp; cp = strtok (0, ","))
+	{
+	  uri_class[num_uri_classes].prefix = cp;
+	  uri_class[num_uri_classes].len = strlen (cp);
+	  ++num_uri_classes;
+	}
+    }
+
+  arg.l = 0;
+  event_register_handler (EV_CALL_SEND_START, send_start, arg);
+  event_register_handler (EV_CALL_RECV_STOP, recv_stop, arg);
+}
+
+static void
+save (int fd)
+{
+  Key_Stats *k;
+  u_int i;
+
+  write_fully (fd, &num_keys, sizeof (num_keys));
+  for (i = 0; i < num_keys; ++i)
+    {
+      k = key[i];
+      write_fully (fd, &k->len, sizeof (k->len));
+      write_fully (fd, k->key, k->len);
+      write_fully (fd, &k->sum, sizeof (k->sum));
+      write_fully (fd, &k->hist, sizeof (k->hist));
+    }
+}
+
+static void
+merge (int fd)
+{
+  u_int i, n;
+  Key_Stats *k;
+  Key_Stats w;
+  char *str;
+
+  if (read_fully (fd, &n, sizeof (n)) < 0)
+    goto failure;
+  for (i = 0; i < n; ++i)
+    {
+      if (read_fully (fd, &w.len, sizeof (w.len)) < 0
+	  || !(str = malloc (w.len + 1))
+	  || read_fully (fd, str, w.len) < 0
+	  || read_fully (fd, &w.sum, sizeof (w.sum)) < 0
+	  || read_fully (fd, &w.hist, sizeof (w.hist)) < 0)
+	goto failure;
+      /* every worker's first key is its "other": */
+      k = i == 0 ? key[0] : intern (str, w.len);
+      k->sum += w.sum;
+      compact_histogram_merge (&k->hist, &w.hist);
+      free (str);
+    }
+  return;
+
+ failure:
+  panic ("%s.uri_stat: failed to merge worker statistics\n", prog_name);
+}
+
+static int
+by_p99 (const void *a, const void *b)
+{
+  const Key_Stats *ka = *(Key_Stats *const *) a;
+  const Key_Stats *kb = *(Key_Stats *const *) b;
+
+  if (ka->p99 != kb->p99)
+    return ka->p99 < kb->p99 ? 1 : -1;
+  if (ka->hist.total != kb->hist.total)
+    return ka->hist.total < kb->hist.total ? 1 : -1;
+  return 0;
+}
+
+static void
+print_key (const Key_Stats *k)
+{
+  u_int i;
+
+  printf ("URI reply time [ms]: %s avg %.3f", k->key,
+	  k->hist.total > 0 ? 1e3 * k->sum / k->hist.total : 0.0);
+  for (i = 0; i < param.percentiles.num; ++i)
+    printf (" p%g %.3f", param.percentiles.p[i],
+	    1e-3 * compact_histogram_percentile (&k->hist,
+						 param.percentiles.p[i]));
+  printf (" max %.3f (%u replies)\n", 1e-3 * k->hist.max, k->hist.total);
+}
+
+static void
+dump (void)
+{
+  Key_Stats **sorted;
+  u_int i, shown;
+
+  sorted = malloc (num_keys * sizeof (sorted[0]));
+  if (!sorted)
+    panic ("%s.uri_stat: out of memory\n", prog_name);
+  for (i = 1; i < num_keys; ++i)
+    {
+      sorted[i] = key[i];
+      sorted[i]->p99 = compact_histogram_percentile (&key[i]->hist, 99);
+    }
+  qsort (sorted + 1, num_keys - 1, sizeof (sorted[0]), by_p99);
+
+  shown = num_keys - 1;
+  if (shown > param.uri_stats.top)
+    shown = param.uri_stats.top;
+  printf ("\nURI statistics: %u keys, slowest %u by p99 reply time",
+	  num_keys - 1, shown);
+  if (key[0]->hist.total > 0)
+    printf (", %u replies beyond the first %u keys in \"other\"",
+	    key[0]->hist.total, param.uri_stats.max_keys);
+  putchar ('\n');
+  for (i = 1; i <= shown; ++i)
+    print_key (sorted[i]);
+  if (key[0]->hist.total > 0)
+    print_key (key[0]);
+  free (sorted);
+}
+
+Stat_Collector uri_stat =
+  {
+    "collects per-URI statistics",
+    init,
+    no_op,
+    no_op,
+    dump,
+    save,
+    merge
+  };
@@ -39,17 +39,38 @@
 #include <string.h>
 
 #include <generic_types.h>
-#include <list.h>
 #include <httperf.h>
 
 #define NUM_TIMERS 25
 
+/*
+ * Pending timers are kept in a hierarchical timing wheel.  Time is
+ * divided into ticks of TIMER_TICK seconds.  The first level has one
+ * slot per tick for the next WHEEL0_SIZE ticks; each further level has
+ * WHEELN_SIZE slots that each cover a whole turn of the level below.
+ * As the wheel turns, the due slot of the next level up is cascaded
+ * down, so each timer is touched a bounded number of times no matter
+ * how many are pending, and cancelling one just unlinks it.
+ */
+#define TIMER_TICK	100e-6
+#define WHEEL0_BITS	8
+#define WHEEL0_SIZE	(1 << WHEEL0_BITS)
+#define WHEELN_BITS	6
+#define WHEELN_SIZE	(1 << WHEELN_BITS)
+#define NUM_LEVELS	5
+#define MAX_TICKS	((1ULL << (WHEEL0_BITS + (NUM_LEVELS - 1) * WHEELN_BITS)) - 1)
+
+struct Timer_Link {
+	struct Timer_Link *next;
+	struct Timer_Link *prev;
+};
+
 static Time     now;
 
 struct Timer {
-	Time            time_started;
-	Time            timeout_delay;
-	bool            has_expired;
+	struct Timer_Link link;		/* must be first */
+	Time            expires;
+	int             level;		/* wheel level the timer sits in */
 
 	/*
 	 * Callback function called when timer expires (timeout) 
@@ -62,18 +83,66 @@ struct Timer {
 	Any_Type        timer_subject;
 };
 
+static struct Timer_Link wheel0[WHEEL0_SIZE];
+static struct Timer_Link wheeln[NUM_LEVELS - 1][WHEELN_SIZE];
+
 /*
- * inactive timers 
+ * Tick of the slot currently being expired.  All earlier ticks have
+ * been fully processed.
  */
-static struct List *passive_timers = NULL;
+static u_wide   wheel_tick;
+static u_int    wheel_count;	/* # of pending timers */
+static u_int    wheel0_count;	/* # of timers in the first level */
+
 /*
- * active timers 
+ * inactive timers, chained through link.next 
  */
-static struct List *active_timers = NULL;
+static struct Timer *passive_timers = NULL;
+
+static void
+link_init(struct Timer_Link *head)
+{
+	head->next = head->prev = head;
+}
+
+static void
+link_insert(struct Timer_Link *head, struct Timer_Link *l)
+{
+	l->next = head;
+	l->prev = head->prev;
+	head->prev->next = l;
+	head->prev = l;
+}
+
+static void
+link_remove(struct Timer_Link *l)
+{
+	l->prev->next = l->next;
+	l->next->prev = l->prev;
+}
+
 /*
- * active timeoutless timers 
+ * Moves all timers on SRC to DST, leaving SRC empty.
  */
-static struct List *persistent_timers = NULL;
+static void
+link_move(struct Timer_Link *dst, struct Timer_Link *src)
+{
+	if (src->next == src) {
+		link_init(dst);
+		return;
+	}
+	dst->next = src->next;
+	dst->prev = src->prev;
+	dst->next->prev = dst;
+	dst->prev->next = dst;
+	link_init(src);
+}
+
+static u_wide
+time_to_tick(Time t)
+{
+	return (u_wide) (t / TIMER_TICK);
+}
 
 /*
  * Returns the time and calls the syscall gettimeofday.  This is an expensive
@@ -109,30 +178,27 @@ timer_now(void)
 bool
 timer_init(void)
 {
-	passive_timers = list_create();
-	if (passive_timers == NULL)
-		goto init_failure;
-
-	active_timers = list_create();
-	if (active_timers == NULL)
-		goto init_failure;
-
-	persistent_timers = list_create();
-	if (persistent_timers == NULL)
-		goto init_failure;
-
-	for (int i = 0; i < NUM_TIMERS; i++) {
-		Any_Type        a;
-		a.vp = malloc(sizeof(struct Timer));
-
-		if (a.vp == NULL)
+	struct Timer   *t;
+	int             i, j;
+
+	for (i = 0; i < WHEEL0_SIZE; i++)
+		link_init(&wheel0[i]);
+	for (i = 0; i < NUM_LEVELS - 1; i++)
+		for (j = 0; j < WHEELN_SIZE; j++)
+			link_init(&wheeln[i][j]);
+	wheel0_count = 0;
+
+	for (i = 0; i < NUM_TIMERS; i++) {
+		t = malloc(sizeof(struct Timer));
+		if (t == NULL)
 			goto init_failure;
 
-		if (list_push(passive_timers, a) == false)
-			goto init_failure;
+		t->link.next = (struct Timer_Link *) passive_timers;
+		passive_timers = t;
 	}
 
 	now = timer_now_forced();
+	wheel_tick = time_to_tick(now);
 
 	return true;
 
@@ -141,84 +207,234 @@ timer_init(void)
 	return false;
 }
 
+static void
+free_slot(struct Timer_Link *head)
+{
+	struct Timer_Link *l, *next;
+
+	for (l = head->next; l != head; l = next) {
+		next = l->next;
+		free(l);
+	}
+	link_init(head);
+}
+
 /*
  * Frees all allocated timers, and timer queues
  */
 void
 timer_free_all(void)
 {
-	while (!is_list_empty(passive_timers)) {
-		Any_Type        a = list_pop(passive_timers);
-		free(a.vp);
+	struct Timer   *t;
+	int             i, j;
+
+	while (passive_timers) {
+		t = passive_timers;
+		passive_timers = (struct Timer *) t->link.next;
+		free(t);
 	}
-	list_free(passive_timers);
-	passive_timers = NULL;
 
-	while (!is_list_empty(active_timers)) {
-		Any_Type        a = list_pop(active_timers);
-		free(a.vp);
+	for (i = 0; i < WHEEL0_SIZE; i++)
+		free_slot(&wheel0[i]);
+	for (i = 0; i < NUM_LEVELS - 1; i++)
+		for (j = 0; j < WHEELN_SIZE; j++)
+			free_slot(&wheeln[i][j]);
+	wheel_count = 0;
+	wheel0_count = 0;
+}
+
+/*
+ * Links T into the wheel slot that covers its expiration time.
+ * Timers that are already due go into the slot being expired.
+ */
+static void
+wheel_insert(struct Timer *t)
+{
+	u_wide          expires, delta;
+	int             level, shift;
+
+	expires = time_to_tick(t->expires);
+	if (expires < wheel_tick)
+		expires = wheel_tick;
+	delta = expires - wheel_tick;
+
+	if (delta < WHEEL0_SIZE) {
+		t->level = 0;
+		++wheel0_count;
+		link_insert(&wheel0[expires & (WHEEL0_SIZE - 1)], &t->link);
+		return;
 	}
-	list_free(active_timers);
-	active_timers = NULL;
 
-	while (!is_list_empty(persistent_timers)) {
-		Any_Type        a = list_pop(persistent_timers);
-		free(a.vp);
+	if (delta > MAX_TICKS) {
+		/* cascaded down again once the top level comes around */
+		delta = MAX_TICKS;
+		expires = wheel_tick + delta;
 	}
-	list_free(persistent_timers);
-	persistent_timers = NULL;
+	for (level = 1, shift = WHEEL0_BITS; level < NUM_LEVELS - 1;
+	    level++, shift += WHEELN_BITS)
+		if (delta < 1ULL << (shift + WHEELN_BITS))
+			break;
+
+	t->level = level;
+	link_insert(&wheeln[level - 1][(expires >> shift) & (WHEELN_SIZE - 1)],
+	    &t->link);
+}
+
+static void
+wheel_remove(struct Timer *t)
+{
+	link_remove(&t->link);
+	--wheel_count;
+	if (t->level == 0)
+		--wheel0_count;
 }
 
 /*
- * Checks whether a timer has expired
+ * Re-inserts the timers of the due slot of each level above the first
+ * whose turn has come.  Must be called whenever wheel_tick advances to
+ * a multiple of WHEEL0_SIZE.
  */
-static bool
-timer_has_expired(Any_Type a)
+static void
+wheel_cascade(void)
 {
-	struct Timer   *t = a.vp;
-
-	/*
-	 * Only expire currently processing timers 
-	 */
-	if (t->has_expired == false) {
-		if (t->time_started + t->timeout_delay < timer_now()) {
-			t->has_expired = true;
-			(*t->timeout_callback) (t, t->timer_subject);
-			return true;
+	struct Timer_Link due, *l;
+	int             level, shift, index;
+
+	for (level = 1, shift = WHEEL0_BITS; level < NUM_LEVELS;
+	    level++, shift += WHEELN_BITS) {
+		index = (wheel_tick >> shift) & (WHEELN_SIZE - 1);
+		link_move(&due, &wheeln[level - 1][index]);
+		while ((l = due.next) != &due) {
+			link_remove(l);
+			wheel_insert((struct Timer *) l);
 		}
+		if (index != 0)
+			break;
 	}
-
-	return false;
 }
 
-static bool
-timer_deactivate(Any_Type a)
+/*
+ * Calls the callback of each timer in the first level slot of
+ * wheel_tick that has expired by now, and returns the timer to the
+ * pool.  Timers in the slot that are not due yet stay where they are.
+ * Callbacks may freely schedule and cancel other timers.
+ */
+static void
+wheel_expire(void)
 {
-	struct Timer   *t = a.vp;
+	struct Timer_Link *slot, pending, keep, *l;
+	struct Timer   *t;
 
-	/* TODO: Error check list_push */
-	if (t->has_expired == true)
-		list_push(passive_timers, a);
+	slot = &wheel0[wheel_tick & (WHEEL0_SIZE - 1)];
+	if (slot->next == slot)
+		return;
+
+	link_move(&pending, slot);
+	link_init(&keep);
+	while ((l = pending.next) != &pending) {
+		t = (struct Timer *) l;
+		link_remove(l);
+		if (t->expires < now) {
+			--wheel_count;
+			--wheel0_count;
+			(*t->timeout_callback) (t, t->timer_subject);
+			t->link.next = (struct Timer_Link *) passive_timers;
+			passive_timers = t;
+		} else
+			link_insert(&keep, l);
+	}
 
-	return t->has_expired;
+	/*
+	 * Put back the timers that are not due yet, after any that the
+	 * callbacks may have added to the slot. 
+	 */
+	while ((l = keep.next) != &keep) {
+		link_remove(l);
+		link_insert(slot, l);
+	}
 }
 
 /*
  * Checks for timers which have had their timeout value pass and executes their
- * callback function.  The timer is then removed from the active timer list
- * and then enqueued back into the passive timer queue
+ * callback function.  The timer is then removed from the wheel and put back
+ * into the passive timer pool.
  */
 void
 timer_tick(void)
+{
+	u_wide          now_tick;
+
+	now = timer_now_forced();
+	now_tick = time_to_tick(now);
+
+	while (1) {
+		wheel_expire();
+		if (wheel_tick >= now_tick)
+			break;
+
+		if (wheel0_count == 0) {
+			/*
+			 * Nothing to expire before the next cascade, so skip
+			 * straight to it. 
+			 */
+			wheel_tick = (wheel_tick | (WHEEL0_SIZE - 1)) + 1;
+			if (wheel_tick > now_tick) {
+				wheel_tick = now_tick;
+				continue;
+			}
+		} else
+			++wheel_tick;
+		if ((wheel_tick & (WHEEL0_SIZE - 1)) == 0)
+			wheel_cascade();
+	}
+}
+
+/*
+ * Returns how many seconds from now timer_tick() will next have work to
+ * do, or a negative value if no timers are pending.  This is when the
+ * earliest timer expires or, if there is none within a turn of the first
+ * level, when the next level up is due to be cascaded.
+ */
+Time
+timer_next_timeout(void)
+{
+	struct Timer_Link *slot, *l;
+	Time            expires, timeout;
+	int             i;
+
+	if (wheel_count == 0)
+		return -1;
+
+	expires = ((wheel_tick | (WHEEL0_SIZE - 1)) + 1) * TIMER_TICK;
+	if (wheel0_count > 0)
+		for (i = 0; i < WHEEL0_SIZE; i++) {
+			slot = &wheel0[(wheel_tick + i) & (WHEEL0_SIZE - 1)];
+			if (slot->next == slot)
+				continue;
+			expires = ((struct Timer *) slot->next)->expires;
+			for (l = slot->next->next; l != slot; l = l->next)
+				if (((struct Timer *) l)->expires < expires)
+					expires = ((struct Timer *) l)->expires;
+			break;
+		}
+
+	timeout = expires - timer_now_forced();
+	return timeout > 0 ? timeout : 0;
+}
+
+/*
+ * Brings the cached time up to date without running any timers, for
+ * when the event loop wakes up after having blocked.
+ */
+void
+timer_refresh(void)
 {
 	now = timer_now_forced();
-	list_for_each(active_timers, &timer_has_expired);
-	list_remove_if_true(active_timers, &timer_deactivate);
 }
 
 /*
- * Schedules a timer into the active_timer list.  Usually the timer is 
- * requisitioned from the passive_timer list to avoid making extra calls
+ * Schedules a timer into the timing wheel.  Usually the timer is 
+ * requisitioned from the passive timer pool to avoid making extra calls
  * to malloc, but will allocate memory for a new counter if there are no
  * inactive timers available
  */
@@ -228,31 +444,18 @@ timer_schedule(void (*timeout) (struct Timer * t, Any_Type arg),
 {
 	struct Timer   *t;
 
-	if (!is_list_empty(passive_timers)) {
-		Any_Type        a = list_pop(passive_timers);
-		t = (struct Timer *) a.vp;
+	if (passive_timers) {
+		t = passive_timers;
+		passive_timers = (struct Timer *) t->link.next;
 	} else if ((t = malloc(sizeof(struct Timer))) == NULL)
 		return NULL;
 
 	memset(t, 0, sizeof(struct Timer));
 	t->timeout_callback = timeout;
-	t->has_expired = false;
 	t->timer_subject = subject;
-	t->time_started = timer_now();
-	t->timeout_delay = delay;
-
-	if (delay > 0 || true)
-	{
-		Any_Type temp;
-		temp.vp = (void *)t;
-		list_push(active_timers, temp);
-	}
-	else
-	{
-		Any_Type temp;
-		temp.vp = (void *)t;
-		list_push(persistent_timers, temp);
-	}
+	t->expires = timer_now() + delay;
+	wheel_insert(t);
+	++wheel_count;
 
 	if (DBG > 2)
 		fprintf(stderr,
@@ -273,5 +476,7 @@ timer_cancel(struct Timer *t)
 	 * being processed (whose timeout has expired).  
 	 */
 
-	t->has_expired = true;
+	wheel_remove(t);
+	t->link.next = (struct Timer_Link *) passive_timers;
+	passive_timers = t;
 }
@@ -45,6 +45,11 @@ void     timer_free_all(void);
  * Needs to be called at least once every TIMER_INTERVAL: 
  */
 void     timer_tick(void);
+/*
+ * Seconds until timer_tick() next has work to do (negative if never): 
+ */
+Time     timer_next_timeout(void);
+void     timer_refresh(void);
 
 struct Timer   *timer_schedule(Timer_Callback timeout, Any_Type arg,
 			       Time delay);
@@ -0,0 +1,10 @@
+#!/bin/sh
+# A reply with an unparsable status line is counted as invalid, not as
+# a server error, and still counts towards the total.
+
+. "${srcdir:-.}/common.sh"
+
+canned_reply 'BOGUS\r\nContent-Length: 0\r\n\r\n'
+run_httperf --num-conns 3 --num-calls 2
+expect 'replies 6 '
+expect 'Reply status: 1xx=0 2xx=0 3xx=0 4xx=0 5xx=0 invalid=6'
@@ -0,0 +1,126 @@
+/*
+    httperf -- a tool for measuring web server performance
+    Copyright 2000-2007 Hewlett-Packard Company
+
+    This file is part of httperf, a web server performance measurment
+    tool.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of this work with the OpenSSL project's
+    "OpenSSL" library (or with modified versions of it that use the same
+    license as the "OpenSSL" library), and distribute linked combinations
+    including the two.  You must obey the GNU General Public License in
+    all respects for all of the code used other than "OpenSSL".  If you
+    modify this file, you may extend this exception to your version of the
+    file, but you are not obligated to do so.  If you do not wish to do
+    so, delete this exception statement from your version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301, USA
+*/
+
+/* A server for the tests: it answers every request (a header without
+   a body) with the contents of the file given as argument, byte for
+   byte, on one connection at a time.  It listens on an ephemeral port
+   of the loopback address, which it prints on stdout, and gives up
+   after a minute in case the test doesn't kill it.  */
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+static char reply[65536];
+static size_t reply_len;
+
+static void
+serve (int sd)
+{
+  static const char eoh[] = "\r\n\r\n";
+  char buf[4096];
+  size_t matched = 0;		/* # of bytes of EOH seen so far */
+  ssize_t i, n;
+
+  while ((n = read (sd, buf, sizeof (buf))) > 0)
+    for (i = 0; i < n; ++i)
+      {
+	if (buf[i] == eoh[matched])
+	  ++matched;
+	else
+	  matched = (buf[i] == eoh[0]);
+	if (matched == sizeof (eoh) - 1)
+	  {
+	    if (write (sd, reply, reply_len) != (ssize_t) reply_len)
+	      return;
+	    matched = 0;
+	  }
+      }
+}
+
+int
+main (int argc, char **argv)
+{
+  struct sockaddr_in sin;
+  socklen_t len;
+  FILE *fp;
+  int sd, s;
+
+  if (argc != 2)
+    {
+      fprintf (stderr, "usage: %s reply-file\n", argv[0]);
+      return 2;
+    }
+  fp = fopen (argv[1], "rb");
+  if (!fp)
+    {
+      perror (argv[1]);
+      return 1;
+    }
+  reply_len = fread (reply, 1, sizeof (reply), fp);
+  fclose (fp);
+
+  sd = socket (AF_INET, SOCK_STREAM, 0);
+  memset (&sin, 0, sizeof (sin));
+  sin.sin_family = AF_INET;
+  sin.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  len = sizeof (sin);
+  if (sd < 0
+      || bind (sd, (struct sockaddr *) &sin, sizeof (sin)) < 0
+      || listen (sd, 16) < 0
+      || getsockname (sd, (struct sockaddr *) &sin, &len) < 0)
+    {
+      perror ("canned_server");
+      return 1;
+    }
+  printf ("%d\n", ntohs (sin.sin_port));
+  fflush (stdout);
+
+  signal (SIGPIPE, SIG_IGN);
+  alarm (60);
+  while ((s = accept (sd, 0, 0)) >= 0)
+    {
+      serve (s);
+      close (s);
+    }
+  perror ("canned_server: accept");
+  return 1;
+}
@@ -0,0 +1,41 @@
+# Helpers for the tests, which are run from the build directory with
+# HTTPERF naming the program to test.
+
+set -e
+
+tmp=$(mktemp -d)
+server=
+cleanup () {
+	test -z "$server" || kill $server 2>/dev/null || :
+	rm -rf "$tmp"
+}
+trap cleanup 0
+
+# Start a server that answers every request with REPLY (in printf(1)
+# notation) and set PORT to where it listens.
+canned_reply () {
+	printf "$1" > "$tmp/reply"
+	./canned_server "$tmp/reply" > "$tmp/port" &
+	server=$!
+	while test ! -s "$tmp/port"; do
+		sleep 0.1
+	done
+	port=$(cat "$tmp/port")
+}
+
+# Run httperf against the server with the given options.
+run_httperf () {
+	$HTTPERF --server 127.0.0.1 --port $port "$@" > "$tmp/out" 2>&1 || {
+		cat "$tmp/out"
+		exit 1
+	}
+}
+
+# Fail unless httperf printed a line containing TEXT.
+expect () {
+	grep -F -e "$1" "$tmp/out" > /dev/null || {
+		echo "expected \`$1' in:"
+		cat "$tmp/out"
+		exit 1
+	}
+}
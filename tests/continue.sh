@@ -0,0 +1,11 @@
+#!/bin/sh
+# A 100 Continue is followed by the final reply, which is parsed from its
+# own status line and counted once, body and all.
+
+. "${srcdir:-.}/common.sh"
+
+canned_reply 'HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok'
+run_httperf --method POST --num-conns 2 --num-calls 3 --phase-stats
+expect 'replies 6 '
+expect 'Reply status: 1xx=0 2xx=6 3xx=0 4xx=0 5xx=0 invalid=0'
+expect 'content 2.0 '